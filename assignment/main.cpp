@@ -4,27 +4,55 @@
 // Includes
 #include <GL/glew.h>
 #include <GL/glut.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <Shader.h>
 #include <Vector.h>
 #include <Matrix.h>
 #include <Mesh.h>
 #include <Texture.h>
+#include <InstanceBuffer.h>
+#include <TransformBatch.h>
+#include <ThreadPool.h>
+#include <Frustum.h>
+#include <RenderQueue.h>
+#include <Profiler.h>
+#include <GpuProfiler.h>
+#include <InputLog.h>
+#include <AudioEngine.h>
+#include <GameState.h>
 #include <SphericalCameraManipulator.h>
 #include <iostream>
 #include <math.h>
+#include <string.h>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <chrono>
+#include <time.h>
 #include <map>
+#include <algorithm>
 
 /*---------------------------------------------------// Function Prototypes //-----------------------------------------------------*/
 // Function Prototypes
 
 // Initialization
 bool initGL(int argc, char **argv);
-void initShader();
+bool initOffscreenGL();
+bool checkGLRequirements();
+bool initShader();
+void initInstancedShader();
+void updateFrameUniforms();
 void initTexture(std::string filename, GLuint &textureID);
-void loadMaze(const std::string &filename, int level);
-void resetGame();
+void markMazeDirty();
+void initAudio();
+void playSound(GameSound sound);
+std::string audioMemoryReport();
+
+// Headless Benchmark
+int runBenchmark();
+void startBenchmarkLevel();
+void applyBenchmarkInput(int frame);
 
 // Input Handling
 void keyboard(unsigned char key, int x, int y);
@@ -33,29 +61,36 @@ void specialKeyboard(int key, int x, int y);
 void specialKeyUp(int key, int x, int y);
 void mouse(int button, int state, int x, int y);
 void motion(int x, int y);
-void handleKeys();
-
-// Timer
-void Timer(int value);
 
-// Updates (Game Logic)
-void updateTankMovement(Vector3f &tankVelocity, float &tankAngle);
-void updateCameraPosition();
-void updateTurretRotation();
-void updateSteeringAngle(float deltaTime);
-void updateBallPosition();
-void updateParticles(float deltaTime);
-void checkfall();
-void fireBall();
+// Input Recording and Replay
+void onKeyboard(unsigned char key, int x, int y);
+void onKeyUp(unsigned char key, int x, int y);
+void onMouse(int button, int state, int x, int y);
+void onMotion(int x, int y);
+bool replayInputs();
+void finishInputLog();
+int runFastReplay();
+
+// Fixed-Timestep Simulation
+void stepSimulation();
+void applyGameEvents();
+void snapRenderState();
+void interpolateRenderState(float alpha);
 
 // Rendering
 void display(void);
 void reshape(int width, int height);
 void DrawMaze();
+void DrawMazeInstances();
+void drawTransformBatch(TransformBatch &transforms, Mesh &mesh, GLuint texture);
+void DrawBakedMaze();
+void updateFrustum();
+void drawMesh(Mesh &mesh, GLuint texture, Matrix4x4 &modelView);
 void DrawTank(float x, float y, float z);
-void DrawBall(float x, float y, float z);
+void DrawBalls();
 void drawParticles();
 void drawHUD();
+void drawStats();
 void render2dText(std::string text, float r, float g, float b, float x, float y);
 
 // Screen size
@@ -64,114 +99,45 @@ int screenHeight = 1080;
 
 /*----------------------------------------------------// Global Variables //-------------------------------------------------------*/
 
-// Environment / Game State
-float g = -9.81f;
+// Lighting and brightness
 float specularPower = 10.0f;
-float remainingTime = 200.0f;
-float flashAlpha = 1.0f;
 float brightness = 1.0f;
 
-bool flashIncreasing = false;
-bool warningPlayed = false;
-bool isPaused = false;
-bool showMenu = false;
-bool mainMenu = true;
-bool gameWon = false;
-bool isGameOver = false;
-bool LowTimeWarning = false;
-bool levelComplete = false;
-
-const int finalLevel = 3;
-int currentLevel = 1;
-int selectedLevel = currentLevel;
-bool levelCompleted[3] = {false, false, false};
-
-// Maze System
-const int MAZE_WIDTH = 15;
-const int MAZE_HEIGHT = 15;
-int MAZE[MAZE_HEIGHT][MAZE_WIDTH];
-
-float centerX = (MAZE_WIDTH - 1);
-float centerZ = (MAZE_HEIGHT - 1);
-
-// Coin System
-int coinsCollected = 0;
-int totalCoins = 0;
-
-float coinRotationAngle = 0.0f;
-float coinBounce = 0.0f;
-
-// Tank State
-Vector3f tankPosition(centerX, 0.0f, centerZ);
-Vector3f tankVelocity(0.0f, 0.0f, 0.0f);
-
-float tankRotation = 0.0f;
-float moveSpeed = 2.0f;
-float rotationSpeed = 1.0f;
-
-// Tank Movement and Physics
-float deltaTime = 0.016f;
-
-float maxSpeed = 10.0f;
-float friction = 3.0f;
-
-float moveDirection = 0.0f;
-float turnDirection = 0.0f;
-
-float wheelRotation = 0.0f;
-float wheelRadius = 0.001f;
+// The game being played - everything the simulation changes, advanced only by step()
+GameState game;
 
-float steeringAngle = 0.0f;
-float steeringSpeed = 10.0f;
-float maxSteeringAngle = 30.0f;
+// Input for the next step: keys held now and presses since the last step
+Input gameInput;
 
-float verticalVelocity = 0.0f;
-float fallRotation = 0.0f;
-float fallSpeed = 140.0f;
-bool isfalling = false;
-bool fallSoundPlayed = false;
+// Static Maze Baking (toggle with B) - crate tiles merged into one mesh per chunk
+bool useBakedMaze = true;
+const int MAZE_CHUNK_SIZE = 8;
+const int MAZE_CHUNKS_I = (MAZE_HEIGHT + MAZE_CHUNK_SIZE - 1) / MAZE_CHUNK_SIZE;
+const int MAZE_CHUNKS_J = (MAZE_WIDTH + MAZE_CHUNK_SIZE - 1) / MAZE_CHUNK_SIZE;
+bool mazeChunkDirty[MAZE_CHUNKS_I][MAZE_CHUNKS_J];
+bool mazeChunkVisible[MAZE_CHUNKS_I][MAZE_CHUNKS_J];
 
-// Jumping
-bool isJumping = false;
-bool isOnGround = true;
+// Fixed-Timestep Simulation - the game always advances in steps of deltaTime seconds
+const float deltaTime = 1.0f / 60.0f;
+const int MAX_STEPS_PER_FRAME = 10; // After a long stall, drop time rather than spiral
+double simulationAccumulator = 0.0;
+double lastSimulationTime = -1.0;
 
-float jumpVelocity = 0.0f;
-const float initialJumpVelocity = 5.0f;
+ShaderProgram mainShader;
 
-// Camera
-float cameraDistance = 7.0f;
-float cameraPan = 0.0f;
-
-bool isFirstPerson = false;
-bool aiming = false;
-
-// Turret
-float turretBaseRotation = 0.0f;
-float targetTurretRotation = 0.0f;
-
-// Ball
-float ballPosX = 0.0f;
-float ballPosY = 6.0f;
-float ballPosZ = 0.0f;
-
-float ballRotationAngle = 0.0f;
-bool ballActive = true;
-bool isBallFired = false;
-
-float ballLifeTime = 0.0f; // Time since ball was fired
-float gravityDelay = 0.2f; // Delay before gravity affects the ball
-Vector3f ballDirection;
-
-GLuint shaderProgramID;
-GLuint vertexPositionAttribute; // Vertex Position Attribute Location
-GLuint vertexNormalAttribute;
-GLuint vertexTexcoordAttribute; // Vertex Texcoord Attribute Location
-
-// Material Properties
-GLuint LightPositionUniformLocation; // Light Position Uniform
-GLuint AmbientUniformLocation;
-GLuint SpecularUniformLocation;
-GLuint SpecularPowerUniformLocation;
+// Per-frame constants shared by every program through the FrameUniforms block (std140 layout)
+struct FrameUniforms
+{
+	float projection[16];
+	float lightPosition[4];
+	float ambient[4];
+	float specular[4];
+	float specularPower;
+	float brightness;
+	float padding[2];
+};
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+UniformBuffer frameUniformBuffer;
 
 // Lighting
 Vector3f lightPosition = Vector3f(20.0, 20.0, 20.0);
@@ -180,11 +146,9 @@ Vector3f specular = Vector3f(1.0, 0.5, 0.0);
 
 // Viewing
 SphericalCameraManipulator cameraManip;
-Matrix4x4 ModelViewMatrix;		  // ModelView Matrix
-GLuint MVMatrixUniformLocation;	  // ModelView Matrix Uniform
+Matrix4x4 ViewMatrix;			  // Camera View Matrix, fetched once per frame
+GLint MVMatrixUniformLocation;	  // ModelView Matrix Uniform
 Matrix4x4 ProjectionMatrix;		  // Projection Matrix
-GLuint ProjectionUniformLocation; // Projection Matrix Uniform Location
-GLuint TextureMapUniformLocation; // Texture Map Location
 
 // Gluint Textures
 GLuint crateTexture;
@@ -209,71 +173,290 @@ Mesh backWheelMesh;	 // Back Wheel Mesh
 // Ball Mesh
 Mesh ballMesh;
 
-// Array of key states
-bool keyStates[256];
+// Baked crate geometry, rebuilt only when a tile in the chunk changes
+Mesh mazeChunkMeshes[MAZE_CHUNKS_I][MAZE_CHUNKS_J];
+
+// Instanced Rendering (toggle with G to A/B against the per-tile loop)
+bool useInstancing = true;
+bool instancingSupported = false;
+
+ShaderProgram instancedShader;
+GLuint instanceMatrixAttribute; // First of four consecutive mat4 column slots
+GLint InstancedViewUniformLocation;
+
+// Per-frame instance transforms for each maze batch
+InstanceBuffer crateInstances;
+InstanceBuffer shadowInstances;
+InstanceBuffer coinInstances;
+InstanceBuffer donutInstances;
+InstanceBuffer ballInstances;
 
-std::map<std::pair<int, int>, int> donutFallTimers;
+// Per-frame positions, yaws and scales of each maze batch, turned into matrices in one pass
+TransformBatch crateTransforms;
+TransformBatch shadowTransforms;
+TransformBatch coinTransforms;
+TransformBatch donutTransforms;
+std::vector<Matrix4x4> mazeTransforms; // View space results for the per-tile path
 
-struct Particle
+// Workers for the transform stage (--threads n), none by default
+ThreadPool *transformPool = NULL;
+
+// Frustum Culling (toggle with F)
+bool useFrustumCulling = true;
+Frustum viewFrustum;
+
+// Per-frame culling counters
+enum CullCategory
+{
+	CULL_CHUNK,
+	CULL_CRATE,
+	CULL_COIN,
+	CULL_DONUT,
+	CULL_TANK,
+	CULL_BALL,
+	CULL_CATEGORY_COUNT
+};
+const char *cullCategoryNames[CULL_CATEGORY_COUNT] = {"Chunks", "Crates", "Coins", "Donuts", "Tank", "Ball"};
+int cullTested[CULL_CATEGORY_COUNT];
+int cullRejected[CULL_CATEGORY_COUNT];
+
+// Render Queue (toggle with O) - sorts opaque draws by program, texture and mesh
+bool useRenderQueue = true;
+RenderQueue renderQueue;
+RenderStats frameStats;
+
+// Performance overlay (toggle with H)
+bool showStats = false;
+float frameTimeMs = 0.0f;
+
+// CPU Profiler (start with --profile [frames], T writes trace.json)
+unsigned int profileFrames = 300;
+
+// GPU time per render pass, shown in the performance overlay
+GpuProfiler gpuProfiler;
+
+// Headless Benchmark (--benchmark [frames] [--level n]) - offscreen EGL context, scripted input, no window
+bool benchmarkMode = false;
+int benchmarkFrames = 1000;
+int benchmarkLevel = 1;
+const int BENCHMARK_WARMUP_FRAMES = 10; // Chunk baking and first uploads are not measured
+GLuint benchmarkFramebuffer = 0;
+GLuint benchmarkRenderbuffers[2] = {0, 0};
+
+// A key held down for a range of frames, repeating every BENCHMARK_SCRIPT_LENGTH frames
+struct ScriptedKey
+{
+	int start;
+	int end;
+	unsigned char key;
+};
+const ScriptedKey benchmarkScript[] = {
+	{0, 360, 'a'},	 // Full turn left - sweeps the camera over the whole maze
+	{360, 372, 'w'}, // Nudge forward
+	{372, 384, 's'}, // and back onto the start tile
+	{400, 405, ' '}, // Jump in place
+	{420, 780, 'd'}, // Full turn right
+};
+const int BENCHMARK_SCRIPT_KEYS = sizeof(benchmarkScript) / sizeof(benchmarkScript[0]);
+const int BENCHMARK_SCRIPT_LENGTH = 800;
+const int BENCHMARK_FIRE_INTERVAL = 60; // Frames between shots
+
+// Input Recording and Replay (--record file, --replay file [--no-render])
+InputLog inputLog;
+bool replayingInput = false;
+bool replayFinished = false;
+bool replayMatched = false;
+
+// False when running without a GLUT window (benchmark, replay without rendering)
+bool hasWindow = true;
+
+// Sound Effects (--audio device|null|file.wav) - mixed in-process, muted without a window unless asked for
+AudioEngine audio;
+std::string audioOutput;
+int soundClips[SOUND_COUNT];
+
+// Render Interpolation - everything that moves is drawn between the last two simulation steps
+struct RenderState
 {
-	Vector3f position;
-	Vector3f velocity;
-	float life;
+	Vector3f tankPosition;
+	float tankRotation;
+	float turretRotation;
+	float wheelRotation;
+	float steeringAngle;
+	float fallRotation;
+
+	// Balls by pool slot, with the launch serial (0 when free) so a reused slot is not blended from its last ball
+	Vector3f ballPositions[ProjectilePool::CAPACITY];
+	float ballRotations[ProjectilePool::CAPACITY];
+	unsigned int ballSerials[ProjectilePool::CAPACITY];
+
+	float coinRotation;
+	float coinBounce;
+
+	float cameraPan;
+	float cameraTilt;
+	float cameraRadius;
+	Vector3f cameraFocus;
+
+	float alpha; // Fraction of a step between previous and current
 };
+RenderState previousState;
+RenderState currentState;
+RenderState renderState;
 
-const int MAX_PARTICLES = 100;
-std::vector<Particle> particles;
-bool spawnParticles = false;
-Vector3f particleOrigin;
+RenderState captureRenderState();
 
 // Main Program Entry
 int main(int argc, char **argv)
 {
-	// Load initial maze layout from file for the current level
-	loadMaze("maze.txt", currentLevel);
+	// Command line options
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (option == "--profile")
+		{
+			Profiler::setEnabled(true);
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+				profileFrames = atoi(argv[++i]);
+		}
+		else if (option == "--benchmark")
+		{
+			benchmarkMode = true;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+				benchmarkFrames = atoi(argv[++i]);
+		}
+		else if (option == "--level" && i + 1 < argc)
+		{
+			benchmarkLevel = std::max(1, std::min(finalLevel, atoi(argv[++i])));
+		}
+		else if (option == "--record" && i + 1 < argc)
+		{
+			// Seed the game so particle bursts can be reproduced too
+			unsigned int seed = (unsigned int)time(NULL);
+			game.randomSeed = seed;
+			if (!inputLog.openForWrite(argv[++i], seed, screenWidth, screenHeight))
+				return -1;
+		}
+		else if (option == "--replay" && i + 1 < argc)
+		{
+			if (!inputLog.openForRead(argv[++i]))
+				return -1;
+			game.randomSeed = inputLog.getHeader().seed;
+			replayingInput = true;
+			std::cout << "Replaying " << inputLog.getEventCount() << " events over " << inputLog.getEndTick() << " ticks" << std::endl;
+		}
+		else if (option == "--no-render")
+		{
+			hasWindow = false;
+		}
+		else if (option == "--audio" && i + 1 < argc)
+		{
+			audioOutput = argv[++i];
+		}
+		else if (option == "--shots" && i + 1 < argc)
+		{
+			// Balls allowed in flight at once for rapid fire - pass the same value when replaying a recording
+			game.shotLimit = std::max(1, std::min(ProjectilePool::CAPACITY, atoi(argv[++i])));
+		}
+		else if (option == "--threads" && i + 1 < argc)
+		{
+			// Caller plus workers for the maze transform stage, 0 for every hardware thread
+			int threads = atoi(argv[++i]);
+			if (threads != 1)
+				transformPool = new ThreadPool(threads);
+		}
+	}
+	if (benchmarkMode)
+		hasWindow = false;
 
-	// init OpenGL
-	if (!initGL(argc, argv))
+	// The recording is closed with the final state hash however the game exits
+	atexit(finishInputLog);
+
+	// Load every level once, then the maze layout for the current level
+	if (!loadLevels(game, "maze.txt"))
 		return -1;
+	loadMaze(game, game.currentLevel);
+	markMazeDirty();
 
-	// Init OpenGL Shader
-	initShader();
+	// Replays without rendering need no OpenGL at all
+	if (replayingInput && !benchmarkMode && !hasWindow)
+		return runFastReplay();
+
+	// init OpenGL - the benchmark renders offscreen without a window
+	if (benchmarkMode ? !initOffscreenGL() : !initGL(argc, argv))
+		return -1;
+	if (!checkGLRequirements())
+		return -1;
 
-	// Init Key States to false;
-	for (int i = 0; i < 256; i++)
-		keyStates[i] = false;
+	// Init OpenGL Shader
+	{
+		PROFILE_ZONE("Load Shaders");
+		if (!initShader())
+			return -1;
+		initInstancedShader();
+	}
+	gpuProfiler.init();
 
 	/*-----------------------------------------// Load Meshes and Textures //---------------------------*/
-	// Load crate model and texture
-	crateMesh.loadOBJ("../models/cube.obj");
-	initTexture("../models/brick.bmp", crateTexture);
-
-	// Load coin model and texture
-	coinMesh.loadOBJ("../models/cube.obj");
-	initTexture("../models/block.bmp", coinTexture);
-	shadowMesh.loadOBJ("../models/cube.obj");
-	initTexture("../models/shadow.bmp", shadowTexture);
-
-	// Load tank components and apply tank textures
-	chassisMesh.loadOBJ("../models/chassis.obj");
-	turretMesh.loadOBJ("../models/turret.obj");
-	frontWheelMesh.loadOBJ("../models/front_wheel.obj");
-	backWheelMesh.loadOBJ("../models/back_wheel.obj");
-	initTexture("../models/hamvee.bmp", tankTexture);
-
-	// Load ball model and texture
-	ballMesh.loadOBJ("../models/ball.obj");
-	initTexture("../models/ball.bmp", ballTexture);
-
-	// Load falling block model and texture
-	donutMesh.loadOBJ("../models/cube.obj");
-	initTexture("../models/donut.bmp", donutTexture);
+	{
+		PROFILE_ZONE("Load Assets");
+
+		// Load crate model and texture
+		{
+			PROFILE_ZONE("Load Crate");
+			crateMesh.loadOBJ("../models/cube.obj");
+			initTexture("../models/brick.bmp", crateTexture);
+		}
+
+		// Load coin model and texture
+		{
+			PROFILE_ZONE("Load Coin");
+			coinMesh.loadOBJ("../models/cube.obj");
+			initTexture("../models/block.bmp", coinTexture);
+			shadowMesh.loadOBJ("../models/cube.obj");
+			initTexture("../models/shadow.bmp", shadowTexture);
+		}
+
+		// Load tank components and apply tank textures
+		{
+			PROFILE_ZONE("Load Tank");
+			chassisMesh.loadOBJ("../models/chassis.obj");
+			turretMesh.loadOBJ("../models/turret.obj");
+			frontWheelMesh.loadOBJ("../models/front_wheel.obj");
+			backWheelMesh.loadOBJ("../models/back_wheel.obj");
+			initTexture("../models/hamvee.bmp", tankTexture);
+		}
+
+		// Load ball model and texture
+		{
+			PROFILE_ZONE("Load Ball");
+			ballMesh.loadOBJ("../models/ball.obj");
+			initTexture("../models/ball.bmp", ballTexture);
+		}
+
+		// Load falling block model and texture
+		{
+			PROFILE_ZONE("Load Donut");
+			donutMesh.loadOBJ("../models/cube.obj");
+			initTexture("../models/donut.bmp", donutTexture);
+		}
+	}
+
+	initAudio();
 
 	// Start main loop
+	if (benchmarkMode)
+		return runBenchmark();
 	glutMainLoop();
 
 	// Clean-Up
-	glDeleteProgram(shaderProgramID);
+	audio.stop();
+	delete transformPool;
+	mainShader.destroy();
+	gpuProfiler.destroy();
+	if (instancingSupported)
+		instancedShader.destroy();
+	frameUniformBuffer.destroy();
 
 	return 0;
 }
@@ -308,40 +491,200 @@ bool initGL(int argc, char **argv)
 
 	glutReshapeFunc(reshape);
 
-	glutKeyboardFunc(keyboard);
-	glutKeyboardUpFunc(keyUp);
+	glutKeyboardFunc(onKeyboard);
+	glutKeyboardUpFunc(onKeyUp);
 
-	glutMouseFunc(mouse);
-	glutMotionFunc(motion);
-	glutPassiveMotionFunc(motion);
+	glutMouseFunc(onMouse);
+	glutMotionFunc(onMotion);
+	glutPassiveMotionFunc(onMotion);
 
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_TEXTURE_2D);
 
-	// Start start timer function after 100 milliseconds
-	glutTimerFunc(100, Timer, 0);
+	return true;
+}
+
+// Function to Initialise an offscreen OpenGL context for the benchmark (Mesa surfaceless or any EGL pbuffer)
+bool initOffscreenGL()
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+
+	// Surfaceless needs no display server or GPU and runs on llvmpipe
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cout << "Failed to initialize EGL" << std::endl;
+		return false;
+	}
+
+	// Desktop GL (compatibility) for the HUD's fixed function drawing
+	eglBindAPI(EGL_OPENGL_API);
+
+	// A pbuffer config if there is one, otherwise a context with no surface at all
+	EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE};
+	EGLConfig config = NULL;
+	EGLint configCount = 0;
+	eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+	EGLContext context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, NULL);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "Failed to create EGL context" << std::endl;
+		return false;
+	}
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (configCount > 0)
+	{
+		EGLint surfaceAttributes[] = {EGL_WIDTH, screenWidth, EGL_HEIGHT, screenHeight, EGL_NONE};
+		surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+	}
+	if (!eglMakeCurrent(display, surface, surface, context))
+	{
+		std::cout << "Failed to make EGL context current" << std::endl;
+		return false;
+	}
 
+	// Init GLEW - a GLX-only build reports no GLX display here, the GL entry points are still loaded
+	glewExperimental = GL_TRUE;
+	GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY)
+		glewStatus = GLEW_OK;
+#endif
+	if (glewStatus != GLEW_OK)
+	{
+		std::cout << "Failed to initialize GLEW" << std::endl;
+		return false;
+	}
+
+	// Render into a framebuffer object so surfaceless and pbuffer contexts behave the same
+	glGenFramebuffers(1, &benchmarkFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, benchmarkFramebuffer);
+	glGenRenderbuffers(2, benchmarkRenderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, benchmarkRenderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, screenWidth, screenHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, benchmarkRenderbuffers[0]);
+	glBindRenderbuffer(GL_RENDERBUFFER, benchmarkRenderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, screenWidth, screenHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, benchmarkRenderbuffers[1]);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Offscreen framebuffer incomplete" << std::endl;
+		return false;
+	}
+
+	std::cout << "Offscreen context: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_2D);
+
+	return true;
+}
+
+// Features every draw relies on - checked once, so an old driver stops here with a message instead of failing on the first draw
+bool checkGLRequirements()
+{
+	// Every Mesh records its attribute layout in a vertex array object
+	if (!GLEW_VERSION_3_0 && !GLEW_ARB_vertex_array_object)
+	{
+		std::cout << "OpenGL 3.0 or ARB_vertex_array_object is required, the driver has OpenGL " << glGetString(GL_VERSION) << std::endl;
+		return false;
+	}
+
+	// The shaders share their per-frame constants through a uniform block, and declare the extension to do so
+	if (!GLEW_ARB_uniform_buffer_object)
+	{
+		std::cout << "ARB_uniform_buffer_object is required, the driver has OpenGL " << glGetString(GL_VERSION) << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Init Shader - every draw goes through the main shader, so the game cannot run without it
+bool initShader()
+{
+	// Create shader - uniforms and attributes are reflected once at link time
+	if (!mainShader.loadFromFile("shader.vert", "shader.frag"))
+	{
+		std::cout << "Failed to link main shader" << std::endl;
+		return false;
+	}
+
+	// Vertex attributes are bound to fixed locations by Shader (see Mesh.h)
+	MVMatrixUniformLocation = mainShader.uniform("MVMatrix_uniform");
+
+	// Per-frame constants live in one buffer shared by every program
+	frameUniformBuffer.create(sizeof(FrameUniforms), FRAME_UNIFORMS_BINDING);
+	mainShader.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+
+	// Every mesh samples unit 0
+	mainShader.use();
+	glUniform1i(mainShader.uniform("Texture_uniform"), 0);
 	return true;
 }
 
-// Init Shader
-void initShader()
+// Init Instanced Shader - only on GL 3.3, whose core glVertexAttribDivisor and glDrawElementsInstanced the instanced path calls
+void initInstancedShader()
+{
+	// The ARB extensions alone are not enough - GLEW loads their entry points under the ARB names only
+	instancingSupported = GLEW_VERSION_3_3;
+	if (!instancingSupported)
+	{
+		std::cout << "Instanced rendering needs OpenGL 3.3, using per-tile drawing" << std::endl;
+		return;
+	}
+
+	// Same lighting as the main shader, model matrix comes from the instance buffer
+	if (!instancedShader.loadFromFile("shader_instanced.vert", "shader.frag"))
+	{
+		std::cout << "Failed to link instanced shader, using per-tile drawing" << std::endl;
+		instancingSupported = false;
+		return;
+	}
+
+	instanceMatrixAttribute = instancedShader.attribute("aInstanceMatrix");
+	InstancedViewUniformLocation = instancedShader.uniform("ViewMatrix_uniform");
+	instancedShader.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+
+	instancedShader.use();
+	glUniform1i(instancedShader.uniform("Texture_uniform"), 0);
+	mainShader.use();
+}
+
+// Fill the FrameUniforms block - one upload per frame instead of per draw
+void updateFrameUniforms()
 {
-	// Create shader
-	shaderProgramID = Shader::LoadFromFile("shader.vert", "shader.frag");
-
-	// Get a handle for our vertex position buffer
-	vertexPositionAttribute = glGetAttribLocation(shaderProgramID, "aVertexPosition");
-	vertexNormalAttribute = glGetAttribLocation(shaderProgramID, "aVertexNormal");
-	vertexTexcoordAttribute = glGetAttribLocation(shaderProgramID, "aVertexTexcoord");
-
-	MVMatrixUniformLocation = glGetUniformLocation(shaderProgramID, "MVMatrix_uniform");
-	ProjectionUniformLocation = glGetUniformLocation(shaderProgramID, "ProjMatrix_uniform");
-	LightPositionUniformLocation = glGetUniformLocation(shaderProgramID, "LightPosition_uniform");
-	AmbientUniformLocation = glGetUniformLocation(shaderProgramID, "Ambient_uniform");
-	SpecularUniformLocation = glGetUniformLocation(shaderProgramID, "Specular_uniform");
-	SpecularPowerUniformLocation = glGetUniformLocation(shaderProgramID, "SpecularPower_uniform");
-	TextureMapUniformLocation = glGetUniformLocation(shaderProgramID, "TextureMap_uniform");
+	FrameUniforms frame;
+	memcpy(frame.projection, ProjectionMatrix.getPtr(), sizeof(frame.projection));
+	frame.lightPosition[0] = lightPosition.x;
+	frame.lightPosition[1] = lightPosition.y;
+	frame.lightPosition[2] = lightPosition.z;
+	frame.lightPosition[3] = 1.0f;
+	frame.ambient[0] = ambient.x;
+	frame.ambient[1] = ambient.y;
+	frame.ambient[2] = ambient.z;
+	frame.ambient[3] = 1.0f;
+	frame.specular[0] = specular.x;
+	frame.specular[1] = specular.y;
+	frame.specular[2] = specular.z;
+	frame.specular[3] = 1.0f;
+	frame.specularPower = specularPower;
+	frame.brightness = brightness;
+	frame.padding[0] = frame.padding[1] = 0.0f;
+	frameUniformBuffer.update(&frame);
 }
 
 void initTexture(std::string filename, GLuint &textureID)
@@ -367,137 +710,175 @@ void initTexture(std::string filename, GLuint &textureID)
 	delete[] data;
 }
 
-// Function to read through a text file to load the maze
-void loadMaze(const std::string &filename, int level)
+// Flag every chunk for rebaking
+void markMazeDirty()
 {
-	std::ifstream file(filename); // Open the maze file for reading
-	if (!file)
-	{
-		std::cerr << "Error: could not open maze file: " << filename << std::endl;
+	for (int ci = 0; ci < MAZE_CHUNKS_I; ++ci)
+		for (int cj = 0; cj < MAZE_CHUNKS_J; ++cj)
+			mazeChunkDirty[ci][cj] = true;
+}
+
+/*----------------------------------------------------// Input Recording and Replay //---------------------------------------------*/
+// GLUT callbacks - live input is recorded with the current tick, and ignored while a replay is running
+void onKeyboard(unsigned char key, int x, int y)
+{
+	if (replayingInput)
 		return;
-	}
+	inputLog.write(game.tick, InputLog::KEY_DOWN, key, 0, x, y);
+	keyboard(key, x, y);
+}
 
-	std::string line;
-	bool levelFound = false;
-	std::string targetLevel = "LEVEL " + std::to_string(level); // Construct the LEVEL header string (e.g. "LEVEL 1")
+void onKeyUp(unsigned char key, int x, int y)
+{
+	if (replayingInput)
+		return;
+	inputLog.write(game.tick, InputLog::KEY_UP, key, 0, x, y);
+	keyUp(key, x, y);
+}
 
-	// Search for the LEVEL header line in the file
-	while (std::getline(file, line))
-	{
-		if (line.find(targetLevel) != std::string::npos)
-		{
-			levelFound = true;
-			break;
-		}
-	}
+void onMouse(int button, int state, int x, int y)
+{
+	if (replayingInput)
+		return;
+	inputLog.write(game.tick, InputLog::MOUSE, button, state, x, y);
+	mouse(button, state, x, y);
+}
 
-	// If the specified level is not found, display error and exit function
-	if (!levelFound)
-	{
-		std::cerr << "Error: Level " << level << " not found in file." << std::endl;
+void onMotion(int x, int y)
+{
+	if (replayingInput)
 		return;
-	}
+	inputLog.write(game.tick, InputLog::MOTION, 0, 0, x, y);
+	motion(x, y);
+}
 
-	totalCoins = 0; // Reset coin count for the new level
+// Feed this tick's recorded events through the same handlers, returns false once the log is finished
+bool replayInputs()
+{
+	if (replayFinished)
+		return false;
 
-	// Clear current maze (initialise all cells to 0)
-	for (int i = 0; i < MAZE_HEIGHT; ++i)
-		for (int j = 0; j < MAZE_WIDTH; ++j)
-			MAZE[i][j] = 0;
+	// Mouse handling depends on the window size the session was recorded at
+	int liveWidth = screenWidth;
+	int liveHeight = screenHeight;
+	screenWidth = inputLog.getHeader().screenWidth;
+	screenHeight = inputLog.getHeader().screenHeight;
 
-	// Read the maze layout after the LEVEL header
-	for (int i = 0; i < MAZE_HEIGHT && std::getline(file, line); ++i)
+	const InputLog::Event *event;
+	while ((event = inputLog.next(game.tick)) != NULL)
 	{
-		std::istringstream iss(line); // Use stringstream to parse each line
-		for (int j = 0; j < MAZE_WIDTH; ++j)
+		switch (event->type)
 		{
-			iss >> MAZE[i][j]; // Read integer into the maze cell
-
-			if (MAZE[i][j] == 2)
-			{
-				totalCoins++; // Count coin tiles
-			}
+		case InputLog::KEY_DOWN:
+			keyboard(event->key, event->x, event->y);
+			break;
+		case InputLog::KEY_UP:
+			keyUp(event->key, event->x, event->y);
+			break;
+		case InputLog::MOUSE:
+			mouse(event->key, event->state, event->x, event->y);
+			break;
+		case InputLog::MOTION:
+			motion(event->x, event->y);
+			break;
 		}
 	}
 
-	file.close(); // Close the file after reading
+	screenWidth = liveWidth;
+	screenHeight = liveHeight;
+
+	if (game.tick < inputLog.getEndTick())
+		return true;
 
-	// Print confirmation with the number of coins found
-	std::cout << "Level " << level << " loaded with " << totalCoins << " coins." << std::endl;
+	// Same tick, same events - the state must now match the recording bit for bit
+	replayFinished = true;
+	replayMatched = hashGameState(game) == inputLog.getEndHash();
+	std::cout << (replayMatched ? "Replay matches the recording" : "Replay diverged from the recording") << std::endl;
+	return false;
 }
 
-/*------------------------------------------------------// Switching Levels Function //--------------------------------------------*/
-void switchLevel(int direction)
+// Called at exit - closes a recording, or reports on a replay that the session's own quit key ended
+void finishInputLog()
 {
-		// Trigger win state if player advances past the final level
-		if (currentLevel == finalLevel)
+	if (inputLog.isRecording())
+	{
+		inputLog.writeEnd(game.tick, hashGameState(game));
+		std::cout << "Recorded " << game.tick << " ticks, state hash " << std::hex << hashGameState(game) << std::dec << std::endl;
+	}
+	else if (replayingInput && !replayFinished)
+	{
+		replayFinished = true;
+		if (game.tick < inputLog.getEndTick())
 		{
-			gameWon = true;
-			levelComplete = false;
-			std::cout << "Game Won" << std::endl;
-			system("canberra-gtk-play -f smb_world_clear.wav &"); // Play win sound
+			std::cout << "Replay stopped at tick " << game.tick << " of " << inputLog.getEndTick() << std::endl;
 			return;
 		}
+		replayMatched = game.tick == inputLog.getEndTick() && hashGameState(game) == inputLog.getEndHash();
+		std::cout << (replayMatched ? "Replay matches the recording" : "Replay diverged from the recording") << std::endl;
+	}
+}
 
-		// Increment or decrement the current level
-		currentLevel += direction;
+// Step through a replay as fast as possible with nothing drawn
+int runFastReplay()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (!replayFinished)
+	{
+		stepSimulation();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-		// Wrap around to the last level if going below level 1
-		if (currentLevel < 1)
-		{
-			currentLevel = 3;
-		}
+	std::cout << "Replayed " << game.tick << " ticks in " << seconds * 1000.0 << " ms ("
+			  << (int)(game.tick / std::max(seconds, 1e-9)) << " ticks/s)" << std::endl;
+	std::cout << "Tank " << game.tankPosition.x << " " << game.tankPosition.y << " " << game.tankPosition.z
+			  << "  coins " << game.coinsCollected << "  state hash " << std::hex << hashGameState(game) << std::dec << std::endl;
 
-	// Reset Coin counter for new level
-	coinsCollected = 0;
+	return replayMatched ? 0 : 1;
+}
 
-	// Reset tank position to the center of the maze
-	tankPosition.x = centerX;
-	tankPosition.z = centerZ;
-	tankPosition.y = 0.0f;
+// Load every sound effect and start the mixer
+void initAudio()
+{
+	// Runs without a window are muted so the audio thread does not skew timings
+	if (audioOutput.empty())
+	{
+		if (!hasWindow)
+			return;
+		audioOutput = "device";
+	}
 
-	// Reset Time Remaining for new level
-	remainingTime = 200;
+	PROFILE_ZONE("Load Sounds");
+	for (int sound = 0; sound < SOUND_COUNT; sound++)
+		soundClips[sound] = audio.load(gameSoundFile((GameSound)sound));
 
-	// Load maze data for the new level
-	loadMaze("maze.txt", currentLevel);
+	if (!audio.start(createAudioBackend(audioOutput)))
+	{
+		std::cout << "Sound disabled" << std::endl;
+		return;
+	}
+	std::cout << "Sounds: " << audio.getClipCount() << " loaded, " << audio.getStreamedClipCount() << " streamed. " << audioMemoryReport() << std::endl;
+}
 
-	// Output confirmation to console
-	std::cout << "Switched to level" << currentLevel << std::endl;
+// Resident sound data - long clips only hold the chunks being played
+std::string audioMemoryReport()
+{
+	AudioEngine::MemoryUsage usage = audio.getMemoryUsage();
+	std::ostringstream report;
+	report << "Audio memory: " << usage.residentBytes() / 1024 << " KB resident (preloaded " << usage.preloadedBytes / 1024
+		   << ", streamed " << usage.streamedResident / 1024 << " of " << usage.streamedBytes / 1024 << " KB mapped)";
+	return report.str();
 }
 
-void resetGame()
+// Start a sound effect - only queues it for the audio thread
+void playSound(GameSound sound)
 {
-	// Reset level state
-	isGameOver = false;
-	remainingTime = 200;
-	coinsCollected = 0;
-	// currentLevel = 1;
-	mainMenu = true;
-	fallRotation = 0.0f;
-	loadMaze("maze.txt", currentLevel);
-
-	// Reset tank position to the center of the maze
-	tankPosition.x = centerX;
-	tankPosition.z = centerZ;
-	tankPosition.y = 0.0f;
+	audio.play(soundClips[sound]);
 }
 
 /*----------------------------------------------------// KeyBoard Interaction //---------------------------------------------------*/
+// Display toggles are handled here, everything else reaches the game at the next step
 void keyboard(unsigned char key, int x, int y)
 {
-	// Quits program when esc is pressed
-	if (key == 27) // esc key code
-	{
-		system("canberra-gtk-play -f smb_pause.wav &");
-		// Toggle in-game menu on ESC key
-		if (!gameWon && !isGameOver && !mainMenu)
-		{
-			showMenu = !showMenu;
-			isPaused = showMenu;
-		}
-	}
-
 	if (key == 'i' || key == 'I') {
 		brightness += 0.2f;
 		if (brightness > 3.0f) {
@@ -511,790 +892,285 @@ void keyboard(unsigned char key, int x, int y)
 		}
 	}
 
-	/*---------------------------------------------------// Menu Navigation Controls //------------------------------------------------*/
-	if (showMenu)
+	// Toggle baked static maze geometry
+	if (key == 'b' || key == 'B')
 	{
-		// Load level 1
-		if (key == '1')
-		{
-			selectedLevel = 1;
-			currentLevel = 1;
-			loadMaze("maze.txt", selectedLevel);
-			showMenu = false;
-			isPaused = false;
-		}
-		// Load level 2 if level 1 is completed
-		else if (key == '2')
-		{
-			if (levelCompleted[0])
-			{
-				selectedLevel = 2;
-				currentLevel = 2;
-				loadMaze("maze.txt", selectedLevel);
-				showMenu = false;
-				isPaused = false;
-			}
-		}
-		// Load level 3 if levels 1 and 2 are completed
-		else if (key == '3')
-		{
-			if (levelCompleted[0] && levelCompleted[1])
-			{
-				selectedLevel = 3;
-				currentLevel = 3;
-				loadMaze("maze.txt", selectedLevel);
-				showMenu = false;
-				isPaused = false;
-			}
-		}
-		// Restart levels
-		else if (key == 'r' || key == 'R')
-		{
-			loadMaze("maze.txt", selectedLevel);
-			showMenu = false;
-			isPaused = false;
-			resetGame();
-			// mainMenu = true;
-			fallSoundPlayed = false;
-		}
-		// Quit the game
-		else if (key == 'q' || key == 'Q')
-		{
-			exit(0);
-		}
+		useBakedMaze = !useBakedMaze;
+		std::cout << "Baked maze geometry: " << (useBakedMaze ? "on" : "off") << std::endl;
 	}
 
-	/*-------------------------------------------------------// Main Menu Controls //-----------------------------------------*/
-	if (mainMenu)
+	// Toggle frustum culling
+	if (key == 'f' || key == 'F')
 	{
-		// Start level 1
-		if (key == '1')
-		{
-			selectedLevel = 1;
-			currentLevel = 1;
-			loadMaze("maze.txt", selectedLevel);
-			showMenu = false;
-			isPaused = false;
-			mainMenu = false;
-		}
-		// Start level 2 if level 1 is completed
-		else if (key == '2')
-		{
-			if (levelCompleted[0])
-			{
-				selectedLevel = 2;
-				currentLevel = 2;
-				loadMaze("maze.txt", selectedLevel);
-				showMenu = false;
-				isPaused = false;
-				mainMenu = false;
-			}
-		}
-		// Start level 3 if levels 1 and 2 are completed
-		else if (key == '3')
-		{
-			if (levelCompleted[0] && levelCompleted[1])
-			{
-				selectedLevel = 3;
-				currentLevel = 3;
-				loadMaze("maze.txt", selectedLevel);
-				showMenu = false;
-				isPaused = false;
-				mainMenu = false;
-			}
-		}
-		// Restart levels from main menu
-		else if (key == 'r' || key == 'R')
-		{
-			loadMaze("maze.txt", currentLevel);
-			showMenu = false;
-			isPaused = false;
-			mainMenu = false;
-			fallSoundPlayed = false;
-			currentLevel = 1;
-			resetGame();
-		}
-		// Quit the game from main menu
-		else if (key == 'q' || key == 'Q')
-		{
-			exit(0);
-		}
+		useFrustumCulling = !useFrustumCulling;
+		std::cout << "Frustum culling: " << (useFrustumCulling ? "on" : "off") << std::endl;
 	}
 
-	/*-------------------------------------------------------// In-Game Controls (when not paused or game over)---------------------*/
-	else if (!isPaused && !isGameOver)
+	// Toggle the sorted render queue
+	if (key == 'o' || key == 'O')
 	{
-		// Next level
-		if ((key == 'n' || key == 'N') && levelComplete && currentLevel < 3 )
-		{
-			if (currentLevel < 3)
-			{
-				switchLevel(1);
-			}	
-			levelComplete = false;
-		}
+		useRenderQueue = !useRenderQueue;
+		std::cout << "Render queue: " << (useRenderQueue ? "on" : "off") << std::endl;
+	}
 
-		// Previous level
-		if (key == 'p' || key == 'P')
-		{
-			switchLevel(-1);
-		}
-		// Enable first-person camera
-		if (key == 'c' || key == 'C')
+	// Toggle performance overlay
+	if (key == 'h' || key == 'H')
+	{
+		showStats = !showStats;
+	}
+
+	// Start the CPU profiler, or write the last frames as a Chrome trace
+	if (key == 't' || key == 'T')
+	{
+		if (!Profiler::isEnabled())
 		{
-			isFirstPerson = true;
+			Profiler::setEnabled(true);
+			std::cout << "Profiler on - press T again to write trace.json" << std::endl;
 		}
-		// Disable first-person camera (switch to third-person)
-		if (key == 'v' || key == 'V')
+		else
 		{
-			isFirstPerson = false;
+			Profiler::writeChromeTrace("trace.json", profileFrames);
 		}
 	}
 
-	/*------------------------------------------------------------------// Game Over / Victory Screen Controls //---------------------------*/
-	// Reset game
-	if ((isGameOver || gameWon) && (key == 'r' || key == 'R'))
+	// Toggle instanced maze rendering
+	if (key == 'g' || key == 'G')
 	{
-		resetGame();
-		gameWon = false;
-		levelComplete = false;
-		// mainMenu = true;
-		fallSoundPlayed = false;
-	}
-	// Quit game
-	if ((isGameOver || gameWon) && (key == 'q' || key == 'Q'))
-	{
-		exit(0);
-		gameWon = false;
+		useInstancing = !useInstancing;
+		std::cout << "Instanced rendering: " << (useInstancing && instancingSupported ? "on" : "off") << std::endl;
 	}
 
+	// Menus, level switching and camera mode
+	gameInput.push(InputEvent::KEY_PRESS, key);
+
 	// Set key status
-	keyStates[key] = true;
+	gameInput.keys[key] = true;
 }
 
 // Handle key up situation
 void keyUp(unsigned char key, int x, int y)
 {
-	keyStates[key] = false;
+	gameInput.keys[key] = false;
 }
 
 void specialKeyboard(int key, int x, int y)
 {
-	keyStates[key] = true;
+	gameInput.keys[key & 0xff] = true;
 }
 
 void specialKeyUp(int key, int x, int y)
 {
-	keyStates[key] = false;
+	gameInput.keys[key & 0xff] = false;
 }
 
 /*--------------------------------------------------------// Mouse Interaction //--------------------------------------------------*/
 void mouse(int button, int state, int x, int y)
 {
-	// Do not process mouse input if the game is paused, over, or in the main menu
-	if (isPaused || isGameOver || mainMenu)
-		return;
-
-	// Left mouse button pressed
-	if (button == GLUT_LEFT_BUTTON)
-	{
-		if (state == GLUT_DOWN)
-		{
-			// Fire a ball from the turret
-			fireBall();
-		}
-	}
+	// Left mouse button fires a ball from the turret
+	if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN)
+		gameInput.push(InputEvent::FIRE);
 
 	// Right mouse button press/ release for aiming mode
 	if (button == GLUT_RIGHT_BUTTON)
-	{
-		if (state == GLUT_DOWN)
-		{
-			// Enter aiming mode
-			aiming = true;
-		}
-		else
-		{
-			// Exit aiming mode
-			aiming = false;
-		}
-	}
-
-	// Update the scene
-	glutPostRedisplay();
+		gameInput.push(state == GLUT_DOWN ? InputEvent::AIM_BEGIN : InputEvent::AIM_END);
 }
 
 /*-------------------------------------------------------------------// Mouse Movement //-----------------------------------------------*/
 void motion(int x, int y)
 {
-	// Only process motion if aiming is active
-	if (!aiming)
-		return;
-
-	// Ignore motion if game is paused or in main menu
-	if (mainMenu || isPaused)
-		return;
-
 	// Ignore motion if mouse is exactly at screen center
 	if (x == screenWidth / 2 && y == screenHeight / 2)
 		return;
 
-	// Calculate mouse delta from the center of the screen
-	float deltaX = -(x - screenWidth / 2); // Horizontal difference (inverted)
-	float dy = (screenHeight / 2 - y);	   // Vertical difference
-
-	// Calculate desired turret rotation angle in degrees
-	targetTurretRotation = atan2(deltaX, dy) * (180.0f / M_PI);
-
-	// Clamp rotation to range [-180, 180] for smooth interpolation
-	if (targetTurretRotation > 180.0f)
-		targetTurretRotation -= 360.0f;
-	if (targetTurretRotation < -180.0f)
-		targetTurretRotation += 360.0f;
-}
-
-/*---------------------------------------------------// HandleKeys Funuction //----------------------------------------------------*/
-void handleKeys()
-{
-	// If the tank is falling, ignore input and update fall behavior only
-	if (isfalling)
-	{
-		moveDirection = 0.0f;
-		turnDirection = 0.0f;
-		checkfall();									// Check if the tank has landed or needs to be reset
-		updateTankMovement(tankVelocity, tankRotation); // Apply physics update
-
-		return;
-	}
-
-	// Do not handle input if in the main menu or game is paused
-	if (mainMenu || isPaused || isGameOver)
-		return;
-	if (levelComplete)
-		return;
-
-	// Handle forward/backward movement (W/S keys)
-	if (keyStates['w'])
-	{
-		moveDirection = 1.0f; // Move forward
-	}
-	else if (keyStates['s'])
-	{
-		moveDirection = -1.0f; // Move backward
-	}
-	else
-	{
-		moveDirection = 0.0f; // No movement
-	}
-
-	// Apply friction if tank exceeds maximum speed
-	if (tankVelocity.length() > maxSpeed)
-	{
-		// Reduce velocity by a factor of friction and time
-		tankVelocity = tankVelocity - tankVelocity * friction * deltaTime;
-	}
-
-	// Update tank position using velocity and deltaTime
-	tankPosition.x += tankVelocity.x * deltaTime;
-	tankPosition.y += tankVelocity.y * deltaTime;
-	tankPosition.z += tankVelocity.z * deltaTime;
-
-	// Handle turning left/right (A/D keys)
-	if (keyStates['a'])
-	{
-		turnDirection = 1.0f; // Turn Left
-	}
-	else if (keyStates['d'])
-	{
-		turnDirection = -1.0f; // Turn right
-	}
-	else
-	{
-		turnDirection = 0.0f; // No turning
-	}
-
-	// Handle jumping (Spacebar)
-	if (keyStates[' '])
-	{
-		// Can only jump if currently on the ground
-		if (isOnGround)
-		{
-			isJumping = true;
-			isOnGround = false;
-			jumpVelocity = initialJumpVelocity;					 // Apply initial upward force
-			system("canberra-gtk-play -f smb_jump-super.wav &"); // Play jump sound
-		}
-	}
-
-	// Apply final tank physics update and check for falling conditions
-	updateTankMovement(tankVelocity, tankRotation);
-	checkfall();
-}
-
-/*-------------------------------------------------------// Timer Function //------------------------------------------------------*/
-void Timer(int value)
-{
-	// Only update time and game state if not in menu, paused, gamer over, or game won
-	if (mainMenu == 0 && !isGameOver && !isPaused && !gameWon && !levelComplete)
-	{
-		float previousTime = remainingTime;
-		remainingTime -= 0.01f; // Decrease remaining time
-
-		// If time runs out, trigger game over
-		if (remainingTime < 0)
-		{
-			remainingTime = 0;
-			isGameOver = true;
-			system("canberra-gtk-play -f smb_gameover.wav &");
-		}
-
-		if (!warningPlayed && remainingTime <= 100.0f)
-		{
-			std::cout << "Play warning sound";
-			system("canberra-gtk-play -f smb_warning.wav &");
-			warningPlayed = true;
-			LowTimeWarning = true;
-		}
-		else if (remainingTime <= 6.0f)
-		{
-			LowTimeWarning = false;
-		}
-	}
-
-	if (LowTimeWarning)
-	{
-		if (flashIncreasing)
-			flashAlpha += 0.05f;
-		else
-			flashAlpha -= 0.05f;
-
-		if (flashAlpha <= 0.2f)
-		{
-			flashAlpha = 0.2f;
-			flashIncreasing = true;
-		}
-		else if (flashAlpha >= 1.0f)
-		{
-			flashAlpha = 1.0f;
-			flashIncreasing = false;
-		}
-	}
-	else
-	{
-		flashAlpha = 1.0f;
-		flashIncreasing = false;
-	}
-
-	// Update the coin animmation:
-	// Rotate the coin for visual spinning effect
-	coinRotationAngle += 2.0f;
-
-	// Keep angle within 0-360 degrees
-	if (coinRotationAngle >= 360.0f)
-	{
-		coinRotationAngle -= 360.0f;
-	}
-
-	// Bounce animation offset for vertical movement of coins
-	coinBounce += 0.1f;
-
-	// Redisplay the scene
-	glutPostRedisplay();
-
-	// Call function again after 10 milli seconds
-	glutTimerFunc(10, Timer, 0);
-}
-
-/*------------------------------------------------// Tank Movement Function //-----------------------------------------------------*/
-void updateTankMovement(Vector3f &tankVelocity, float &tankAngle)
-{
-	// Apply Turning
-	tankRotation = tankRotation + turnDirection * rotationSpeed;
-
-	// Convert rotation to direction
-	float rad = tankRotation * (M_PI / 180.0f);
-	Vector3f forward(sin(rad), 0.0f, cos(rad));
-
-	// Update velocity
-	tankVelocity = forward * (moveSpeed * moveDirection);
-
-	// Apply Friction if no input
-	if (moveDirection == 0.0f)
-	{
-		tankVelocity = tankVelocity * 0.9f;
-	}
-
-	// Update tank Position
-	tankPosition = tankPosition + tankVelocity * deltaTime;
-
-	// Calculate rotation amount
-	wheelRotation += (moveSpeed * moveDirection * deltaTime) / wheelRadius;
-
-	if (!isOnGround)
-	{
-		// Apply gravity
-		jumpVelocity += g * deltaTime;
-		tankPosition.y += jumpVelocity * deltaTime;
-
-		// Check if tank lands
-		if (tankPosition.y <= 0.0f)
-		{
-			tankPosition.y = 0.0f;
-			isOnGround = true;
-			isJumping = false;
-			jumpVelocity = 0.0f;
-
-			checkfall();
-		}
-	}
-
-	if (isfalling && fallRotation < 90.0f)
-	{
-		fallRotation += deltaTime * fallSpeed; // fallSpeed could be ~45–90 degrees/sec
-		if (fallRotation > 90.0f)
-			fallRotation = 90.0f; // Clamp to 90
-	}
-}
-
-/*-----------------------------------------------------// Camera Function //-------------------------------------------------------*/
-void updateCameraPosition()
-{
-	// Only update the camera if the tank is not falling
-	if (!isfalling)
-	{
-		/*---------------------------------------// FIRST PERSON CAMERA MODE //-----------------------------------------------------------*/
-		if (isFirstPerson)
-		{
-			// Calculate tanks orientation in world space
-			float targetpan = (tankRotation + turretBaseRotation) * (M_PI / 180.0f);
-			float smoothing = 10.0f;
-			cameraPan += (targetpan - cameraPan) * smoothing * deltaTime;
-
-			// Cockpit camera setting
-			float tilt = -1.3f;	 // Slight downward angle
-			float radius = 0.2f; // Close to the tank
-
-			// Position camera slightly above the tank to simulate a cockpit view
-			float verticalOffset = 2.0f;
-			float cameraY = tankPosition.y + verticalOffset;
-			float cameraZ = tankPosition.z;
-			float cameraX = tankPosition.x;
-
-			// Focus point is directly above the tank chassis
-			Vector3f focusPoint(cameraX, cameraY, cameraZ);
-
-			// Set camera orientation and position
-			cameraManip.setPanTiltRadius(cameraPan, tilt, radius);
-			cameraManip.setFocus(focusPoint);
-		}
-		/*--------------------------------------------------------// THIRD PERSON CAMERA MODE //-----------------------------------------------*/
-		else
-		{
-			// Calculate tanks orientation in world space
-			float targetpan = (tankRotation + turretBaseRotation) * (M_PI / 180.0f);
-			float smoothing = 5.0f;
-			cameraPan += (targetpan - cameraPan) * smoothing * deltaTime;
-
-			// Third person camera settings
-			float radius = cameraDistance; // Camera follows from behind
-			float tilt = -1.0f;			   // Higher angle than first person
-
-			// Set camera to follow the tank from a distance
-			cameraManip.setPanTiltRadius(cameraPan, tilt, radius);
-			cameraManip.setFocus(tankPosition);
-		}
-	}
-}
-
-/*------------------------------------------------------// Rotating Turret Function //----------------------------------------------*/
-void updateTurretRotation()
-{
-	// Do not rotate the turret while the tank is falling
-	if (isfalling)
-		return;
-
-	// Calculate the angular difference between current turret rotation and target
-	float angleDifference = targetTurretRotation - turretBaseRotation;
-
-	// Normalise the angle difference to stay within [-180, 180]
-	if (angleDifference > 180.0f)
-		angleDifference -= 360.0f;
-	if (angleDifference < -180.0f)
-		angleDifference += 360.0f;
-
-	// Apply smooth rotation if the difference is significant
-	if (fabs(angleDifference) > 0.01f)
-	{
-		// Interpolate the turret rotation by 10% of the angle difference
-		turretBaseRotation += angleDifference * 0.1f;
-	}
-}
-
-/*--------------------------------------------------------// Steering Function //-------------------------------------------------*/
-void updateSteeringAngle(float deltaTime)
-{
-	const float maxSteeringAngle = 15.0f; // Maximum angle the wheels can steer (in degrees)
-	const float returnSpeed = 60.0f;	  // Speed at which the steering returns to center (degrees/sec)
-
-	// Turn right (positive turn direction)
-	if (turnDirection > 0.0f)
-	{
-		steeringAngle += steeringSpeed * deltaTime; // Increase angle over time
-		if (steeringAngle > maxSteeringAngle)
-			steeringAngle = maxSteeringAngle; // Clamp to maximum right
-	}
-	// Turn left (negative turn direction)
-	else if (turnDirection < 0.0f)
-	{
-		steeringAngle -= steeringSpeed * deltaTime; // Decrease angle over time
-		if (steeringAngle < -maxSteeringAngle)
-			steeringAngle = -maxSteeringAngle; // Clamp to maximum left
-	}
-	// Return to center if no input
-	else
-	{
-		if (steeringAngle > 0.0f)
-		{
-			steeringAngle -= returnSpeed * deltaTime;
-			if (steeringAngle < 0.0f)
-				steeringAngle = 0.0f;
-		}
-		else if (steeringAngle < 0.0f)
-		{
-			steeringAngle += returnSpeed * deltaTime;
-			if (steeringAngle > 0.0f)
-				steeringAngle = 0.0f;
-		}
-	}
-
-	// Clamp to ensure steering angle is within bounds
-	if (steeringAngle > maxSteeringAngle)
-		steeringAngle = maxSteeringAngle;
-	if (steeringAngle < -maxSteeringAngle)
-		steeringAngle = -maxSteeringAngle;
+	// Mouse delta from the center of the screen - the game turns it into a turret angle while aiming
+	float deltaX = -(x - screenWidth / 2); // Horizontal difference (inverted)
+	float dy = (screenHeight / 2 - y);	   // Vertical difference
+	gameInput.push(InputEvent::AIM_MOVE, 0, deltaX, dy);
 }
 
-/*-----------------------------------------------------// Update position of the fired ball //-----------------------------------------*/
-void updateBallPosition()
+/*-----------------------------------------------// Fixed-Timestep Simulation //---------------------------------------------------*/
+void stepSimulation()
 {
-	// Return early if the ball is not active or hasn't been fired
-	if (!ballActive)
-		return;
-	if (!isBallFired)
-		return;
+	PROFILE_ZONE("stepSimulation");
 
-	// Update the lifetime of the ball since it was fired
-	ballLifeTime += deltaTime;
+	// Replayed input is handled at the same tick it was recorded on
+	if (replayingInput && !replayInputs())
+		return;
 
-	// Move the ball in the horizontal (XZ) plane
-	ballPosX += ballDirection.x * deltaTime;
-	ballPosZ += ballDirection.z * deltaTime;
+	step(game, gameInput, deltaTime);
+	gameInput.events.clear();
 
-	// Apply eased gravity effect after a short delay
-	if (ballLifeTime >= gravityDelay)
-	{
-		float t = (ballLifeTime - gravityDelay);
-		float easedGravity = g * (1.0f - expf(-3.0f * t)); // Smooth gravity acceleration
-		verticalVelocity += easedGravity * 30.0f * deltaTime;
-	}
+	applyGameEvents();
+}
 
-	// Update the vertical position
-	ballPosY += verticalVelocity * deltaTime;
+// Play the step's sounds and pass its changes on to the renderer and camera
+void applyGameEvents()
+{
+	for (size_t i = 0; i < game.events.sounds.size(); i++)
+		playSound(game.events.sounds[i]);
 
-	// If the ball hits the ground deactivate it
-	if (ballPosY <= 0.9f)
+	// Coin pickups (2 -> 1) keep the crate, so only crate add/remove needs a rebake
+	for (size_t i = 0; i < game.events.tiles.size(); i++)
 	{
-		ballPosY = 0.0f;
-		ballActive = false;
-		isBallFired = false;
+		const TileChange &change = game.events.tiles[i];
+		bool wasCrate = (change.from == 1 || change.from == 2);
+		bool isCrate = (change.to == 1 || change.to == 2);
+		if (wasCrate != isCrate)
+			mazeChunkDirty[change.i / MAZE_CHUNK_SIZE][change.j / MAZE_CHUNK_SIZE] = true;
 	}
+	if (game.events.levelLoaded)
+		markMazeDirty();
 
-	// conmvert ball position to tile indices in the maze grid
-	int ballTileX = (int)((ballPosX + 1.0f) / 2.0f);
-	int ballTileZ = (int)((ballPosZ + 1.0f) / 2.0f);
-
-	// Check if ball is within the maze bounds
-	if (ballTileZ >= 0 && ballTileX < MAZE_HEIGHT && ballTileX >= 0 && ballTileZ < MAZE_WIDTH)
-	{
-		// If the ball hits a coin tile
-		if (MAZE[ballTileX][ballTileZ] == 2)
-		{
-			MAZE[ballTileX][ballTileZ] = 1; // Remove Coin
-			coinsCollected++;				// Increment the player's score
-
-			// Play the coin collected sound
-			system("canberra-gtk-play -f smb_coin.wav &");
-
-			// Spawn visual particles
-			spawnParticles = true;
-			particleOrigin = Vector3f(ballTileX, ballPosY, ballPosZ);
-			particles.clear();
-			for (int i = 0; i < MAX_PARTICLES; ++i)
-			{
-				Particle p;
-				p.position = particleOrigin;
-				p.velocity = Vector3f(
-					(rand() % 100 - 50) / 50.0f,  // Random X velocity
-					(rand() % 100) / 50.0f,		  // Random Y velocity
-					(rand() % 100 - 50) / 50.0f); // Random Z velocity
-				p.life = 1.0f;					  // Each particle lives for 1 second
-				particles.push_back(p);
-			}
-
-			std::cout << "Coins Collected: " << coinsCollected << std::endl;
-
-			// If all coins are collected, mark level as comoplete and switch to next
-			if (coinsCollected == totalCoins)
-			{
-				levelCompleted[currentLevel - 1] = true;
-				levelComplete = true;
+	cameraManip.setPanTiltRadius(game.cameraPan, game.cameraTilt, game.cameraRadius);
+	cameraManip.setFocus(game.cameraFocus);
 
-				if (currentLevel == 3) {
-					gameWon = true;
-					system("canberra-gtk-play -f smb_world_clear.wav &"); // Play win sound
-				}
-				// switchLevel(1); // Load next level
-				if (currentLevel < 3)
-				{
-					system("canberra-gtk-play -f smb_stage_clear.wav &"); // Victory sound
-				}
-				coinsCollected = 0; // Reset for next level
-			}
-		}
-	}
+	if (game.events.quit)
+		exit(0);
 }
 
-/*---------------------------------------------------// Updates active particles //------------------------------------*/
-void updateParticles(float deltaTime)
+// Snapshot of everything the draw functions interpolate
+RenderState captureRenderState()
 {
-	// If no particles are currently spawned, exit early
-	if (!spawnParticles)
-		return;
-
-	// Update each particle's lifetime and position
-	for (auto &p : particles)
+	RenderState state;
+	state.tankPosition = game.tankPosition;
+	state.tankRotation = game.tankRotation;
+	state.turretRotation = game.turretBaseRotation;
+	state.wheelRotation = game.wheelRotation;
+	state.steeringAngle = game.steeringAngle;
+	state.fallRotation = game.fallRotation;
+	const ProjectilePool &balls = game.projectiles;
+	for (int slot = 0; slot < ProjectilePool::CAPACITY; slot++)
 	{
-		p.life -= deltaTime;							  // Decrease particle lifetime
-		p.position = p.position + p.velocity * deltaTime; // Move particle according to velocity
+		bool inFlight = slot < balls.getSlotLimit() && balls.active[slot] != 0.0f;
+		state.ballPositions[slot] = Vector3f(balls.positionX[slot], balls.positionY[slot], balls.positionZ[slot]);
+		state.ballRotations[slot] = balls.rotation[slot];
+		state.ballSerials[slot] = inFlight ? balls.serial[slot] : 0;
 	}
+	state.coinRotation = game.coinRotationAngle;
+	state.coinBounce = game.coinBounce;
+	state.cameraPan = cameraManip.getPan();
+	state.cameraTilt = cameraManip.getTilt();
+	state.cameraRadius = cameraManip.getRadius();
+	state.cameraFocus = cameraManip.getFocus();
+	state.alpha = 1.0f;
+	return state;
+}
 
-	// Check if any particles are still alive
-	bool anyAlive = false;
-	for (const auto &p : particles)
-	{
-		if (p.life > 0.0f)
-		{
-			anyAlive = true; // At least one particle is still active
-			break;
-		}
-	}
-	// If all particles have expired, stop spawning particles
-	if (!anyAlive)
-		spawnParticles = false;
+// Start drawing from the current state with nothing to interpolate
+void snapRenderState()
+{
+	currentState = captureRenderState();
+	previousState = currentState;
+	renderState = currentState;
 }
 
-/*------------------------------------------------// Tank Falling Function //------------------------------------------------------*/
-void checkfall()
+float lerp(float a, float b, float t)
 {
-	// Convert tank world position to maze indices
-	int i = static_cast<int>(round(tankPosition.x / 2.0f));
-	int j = static_cast<int>(round(tankPosition.z / 2.0f));
+	return a + (b - a) * t;
+}
 
-	bool onCrate = false;
+Vector3f lerp(Vector3f a, Vector3f b, float t)
+{
+	return Vector3f(lerp(a.x, b.x, t), lerp(a.y, b.y, t), lerp(a.z, b.z, t));
+}
 
-	// If the tank is already in the air, skip further checkss
-	if (!isOnGround)
-		return;
+// Interpolate along the short way round for angles that wrap
+float lerpAngle(float a, float b, float t, float period)
+{
+	float difference = fmod(b - a, period);
+	if (difference > period * 0.5f)
+		difference -= period;
+	if (difference < -period * 0.5f)
+		difference += period;
+	return a + difference * t;
+}
 
-	// Make sure the indices are within maze bounds before checking
-	if (i >= 0 && j >= 0 && i < MAZE_WIDTH && j < MAZE_HEIGHT)
+void interpolateRenderState(float alpha)
+{
+	renderState.tankPosition = lerp(previousState.tankPosition, currentState.tankPosition, alpha);
+	renderState.tankRotation = lerp(previousState.tankRotation, currentState.tankRotation, alpha);
+	renderState.turretRotation = lerp(previousState.turretRotation, currentState.turretRotation, alpha);
+	renderState.wheelRotation = lerp(previousState.wheelRotation, currentState.wheelRotation, alpha);
+	renderState.steeringAngle = lerp(previousState.steeringAngle, currentState.steeringAngle, alpha);
+	renderState.fallRotation = lerp(previousState.fallRotation, currentState.fallRotation, alpha);
+	for (int slot = 0; slot < ProjectilePool::CAPACITY; slot++)
 	{
-		// If the current tile has a crate or valid platform (value >= 1), its safe
-		if (MAZE[i][j] >= 1)
+		// A ball that has just left the barrel starts there rather than where the slot's last ball landed
+		renderState.ballSerials[slot] = currentState.ballSerials[slot];
+		if (previousState.ballSerials[slot] != currentState.ballSerials[slot])
 		{
-			onCrate = true;
+			renderState.ballPositions[slot] = currentState.ballPositions[slot];
+			renderState.ballRotations[slot] = currentState.ballRotations[slot];
+			continue;
 		}
+		renderState.ballPositions[slot] = lerp(previousState.ballPositions[slot], currentState.ballPositions[slot], alpha);
+		renderState.ballRotations[slot] = lerpAngle(previousState.ballRotations[slot], currentState.ballRotations[slot], alpha, 360.0f);
 	}
+	renderState.coinRotation = lerpAngle(previousState.coinRotation, currentState.coinRotation, alpha, 360.0f);
+	renderState.coinBounce = lerp(previousState.coinBounce, currentState.coinBounce, alpha);
+	renderState.cameraPan = lerpAngle(previousState.cameraPan, currentState.cameraPan, alpha, 2.0f * M_PI);
+	renderState.cameraTilt = lerp(previousState.cameraTilt, currentState.cameraTilt, alpha);
+	renderState.cameraRadius = lerp(previousState.cameraRadius, currentState.cameraRadius, alpha);
+	renderState.cameraFocus = lerp(previousState.cameraFocus, currentState.cameraFocus, alpha);
+	renderState.alpha = alpha;
+
+	// The camera is rebuilt from the blended values - the next step overwrites them again
+	cameraManip.setPanTiltRadius(renderState.cameraPan, renderState.cameraTilt, renderState.cameraRadius);
+	cameraManip.setFocus(renderState.cameraFocus);
+}
 
-	// If not on a crate, the tank should fall
-	if (!onCrate)
-	{
-		isfalling = true;
-	}
-	else
-	{
-		// Tank is safely grounded on a crate or platform
-		isfalling = false;
-		tankPosition.y = 0.0f;	 // Reset Y position to ground level
-		verticalVelocity = 0.0f; // Reset vertical velocity
-	}
+/*-----------------------------------------------// Display Loop //----------------------------------------------------------------*/
+void display(void)
+{
+	Profiler::beginFrame();
+	PROFILE_ZONE("display");
 
-	// If the tank is falling, apply gravity and update vertical position
-	if (isfalling)
+	// Real elapsed time since the previous frame
+	double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (lastSimulationTime < 0.0)
 	{
-		verticalVelocity += g * 10.0f * deltaTime;	   // Accelerate downward
-		tankPosition.y = verticalVelocity * deltaTime; // Update Y position
-
-		isGameOver = true; // Trigger game over state
-
-		// Play falling sound once
-		if (!fallSoundPlayed)
-		{
-			system("canberra-gtk-play -f plankton.wav &");
-			fallSoundPlayed = true;
-		}
+		lastSimulationTime = now;
+		snapRenderState();
 	}
-}
-
-/*-----------------------------------------// Fires a projectile //--------------------------------------------------------*/
-void fireBall()
-{
-	// Only fire if a ball is not active
-	if (!isBallFired)
-	{
-		// Set initial position to the turret
-		ballPosX = tankPosition.x;
-		ballPosY = tankPosition.y + 2.0f; // Height above the tank
-		ballPosZ = tankPosition.z;
-
-		// Calculate direction based on tank and turret rotation
-		float angle = (tankRotation + turretBaseRotation) * (M_PI / 180.0f);
-		float dirX = sin(angle);
-		float dirZ = cos(angle);
-
-		// Normalise direction vector
-		float length = sqrt(dirX * dirX + dirZ * dirZ);
-		if (length != 0.0f)
-		{
-			dirX /= length;
-			dirZ /= length;
-		}
+	double frameSeconds = now - lastSimulationTime;
+	lastSimulationTime = now;
 
-		// Fire slightly in front of tank barrel
-		float offset = 0.8f;
-		ballPosX = tankPosition.x + dirX * offset;
-		ballPosZ = tankPosition.z + dirZ * offset;
+	// The benchmark advances exactly one step per frame so every run simulates the same game
+	if (benchmarkMode)
+		frameSeconds = deltaTime;
 
-		// Assign horizontal directional velocity to the ball
-		ballDirection = Vector3f(dirX, 0.0f, dirZ) * 12.0f;
+	// Smoothed frame time for the performance overlay
+	frameTimeMs = frameTimeMs * 0.9f + (float)(frameSeconds * 1000.0) * 0.1f;
 
-		// Reset vertical velocity and lifetime before launch
-		verticalVelocity = 0.0f;
-		ballLifeTime = 0.0f;
+	// Advance the simulation in fixed steps, independent of the frame rate
+	simulationAccumulator += frameSeconds;
 
-		// Activate ball
-		isBallFired = true;
-		ballActive = true;
-		// Play firing sound effect
-		system("canberra-gtk-play -f smb_fireball.wav &");
+	int steps = 0;
+	while (simulationAccumulator >= deltaTime && steps < MAX_STEPS_PER_FRAME)
+	{
+		previousState = currentState;
+		stepSimulation();
+		currentState = captureRenderState();
+
+		// Drop interpolation after a teleport (level switch, reset) so nothing slides across the maze
+		if (game.events.teleported)
+			previousState = currentState;
+		simulationAccumulator -= deltaTime;
+		steps++;
 	}
-}
+	if (simulationAccumulator >= deltaTime)
+		simulationAccumulator = 0.0;
 
-/*-----------------------------------------------// Display Loop //----------------------------------------------------------------*/
-void display(void)
-{
-	// Handle keys
-	handleKeys();
+	// A windowed replay closes once the recorded session is over
+	if (replayFinished && hasWindow)
+		exit(replayMatched ? 0 : 1);
+
+	// Draw between the last two steps
+	interpolateRenderState((float)(simulationAccumulator / deltaTime));
+
+	// Pick up GPU pass times from a few frames ago
+	gpuProfiler.beginFrame();
+	int gpuFramePass = gpuProfiler.beginPass("Frame");
 
 	// Set Viewport
 	glViewport(0, 0, screenWidth, screenHeight);
@@ -1304,80 +1180,54 @@ void display(void)
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Use shader
-	glUseProgram(shaderProgramID);
+	frameStats.reset();
+	mainShader.use();
+	frameStats.programBinds++;
 
-	glUseProgram(shaderProgramID);
-	glUniform1f(glGetUniformLocation(shaderProgramID, "brightness"), brightness);
+	// Every mesh samples unit 0
+	glActiveTexture(GL_TEXTURE0);
 
 	// Projection Matrix - Perspective Projection
 	ProjectionMatrix.perspective(90, 1.0, 0.0001, 100.0);
 
-	// Set Projection Matrix
-	glUniformMatrix4fv(
-		ProjectionUniformLocation,	// Uniform location
-		1,							// Number of Uniforms
-		false,						// Transpose Matrix
-		ProjectionMatrix.getPtr()); // Pointer to ModelViewMatrixValues
-
-	glUniform3f(LightPositionUniformLocation, lightPosition.x, lightPosition.y, lightPosition.z);
-	glUniform4f(AmbientUniformLocation, ambient.x, ambient.y, ambient.z, 1.0);
-	glUniform4f(SpecularUniformLocation, specular.x, specular.y, specular.z, 1.0);
-	glUniform1f(SpecularPowerUniformLocation, specularPower);
+	// Upload per-frame constants once for every program
+	updateFrameUniforms();
 
 	// Apply the camera view using gluLookAt
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 
-	// Draw 3D game elements
-	DrawMaze();					// Draw the maze
-	DrawTank(0.0f, 3.0f, 0.0f); // Draw the tank
-	updateBallPosition();		// Update the ball's physics state
-	DrawBall(0.0f, 6.0f, 0.0f); // Render the projectile
-	drawParticles();			// Render coin particle over time
-	updateParticles(deltaTime); // Update particles over time
+	// Camera is only rebuilt when it moved since the last frame
+	ViewMatrix = cameraManip.getViewMatrix();
 
-	// Update tank Controls
-	updateSteeringAngle(deltaTime);
-	updateTurretRotation();
-	updateCameraPosition();
-
-	// Crosshair for aiming
-	glutSetCursor(GLUT_CURSOR_CROSSHAIR);
-
-	// Tank collecting coins
-	int tankTileX = (int)((tankPosition.x + 1.0f) / 2.0f);
-	int tankTileZ = (int)((tankPosition.z + 1.0f) / 2.0f);
-	if (tankTileZ >= 0 && tankTileX < MAZE_HEIGHT && tankTileX >= 0 && tankTileZ < MAZE_WIDTH)
+	// Draw 3D game elements - with the render queue on, queued meshes are timed under "Queue"
+	updateFrustum(); // Cull against this frame's camera
 	{
-		if (MAZE[tankTileX][tankTileZ] == 2) // 2 indicates a coin tile
-		{
-			MAZE[tankTileX][tankTileZ] = 1; // Remove coin
-			coinsCollected++;				// Increment collection count
-
-			// Play coin collection sound
-			system("canberra-gtk-play -f smb_coin.wav &");
-
-			std::cout << "Coins collected: " << coinsCollected << std::endl;
-
-			// If all coins are collected switch level
-			if (coinsCollected == totalCoins)
-			{
-				levelCompleted[currentLevel - 1] = true; // Set level as completed
-				levelComplete = true;
-				if (currentLevel == 3) {
-					gameWon = true;
-					system("canberra-gtk-play -f smb_world_clear.wav &"); // Play win sound
-				}
-				// switchLevel(1);
-				if (currentLevel < 3)
-				{
-					system("canberra-gtk-play -f smb_stage_clear.wav &"); // Play  level victory sound
-				}
-				coinsCollected = 0; // Reset coins for new level
-			}
-		}
+		GpuZone pass(gpuProfiler, "Maze");
+		DrawMaze(); // Draw the maze
+	}
+	{
+		GpuZone pass(gpuProfiler, "Tank");
+		DrawTank(0.0f, 3.0f, 0.0f); // Draw the tank
+	}
+	{
+		GpuZone pass(gpuProfiler, "Ball");
+		DrawBalls(); // Render the projectiles
+	}
+	{
+		PROFILE_ZONE("RenderQueue::flush");
+		GpuZone pass(gpuProfiler, "Queue");
+		renderQueue.flush(frameStats); // Submit queued opaque draws sorted by state
+	}
+	{
+		GpuZone pass(gpuProfiler, "Particles");
+		drawParticles(); // Render coin particle over time
 	}
 
+	// Crosshair for aiming
+	if (hasWindow)
+		glutSetCursor(GLUT_CURSOR_CROSSHAIR);
+
 	// Unuse Shader
 	glUseProgram(0);
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -1394,10 +1244,20 @@ void display(void)
 	glPushMatrix();
 	glLoadIdentity();
 
-	drawHUD();
-	// Redraw frame
+	{
+		GpuZone pass(gpuProfiler, "HUD");
+		drawHUD();
+	}
+	gpuProfiler.endPass(gpuFramePass);
+
+	// Redraw frame - the benchmark drives display() itself and has no window to swap
+	if (!hasWindow)
+		return;
 	glutPostRedisplay();
-	glutSwapBuffers();
+	{
+		PROFILE_ZONE("glutSwapBuffers");
+		glutSwapBuffers();
+	}
 }
 
 void reshape(int width, int height)
@@ -1411,212 +1271,481 @@ void reshape(int width, int height)
 
 	// Update Projection Matrix
 	ProjectionMatrix.perspective(90, (float)width / height, 0.0001, 100.0);
-	glUniformMatrix4fv(ProjectionUniformLocation, 1, false, ProjectionMatrix.getPtr());
+}
+
+/*-----------------------------------------------// Headless Benchmark //-------------------------------------------------------------*/
+// Start (or restart) the benchmark level as if it had been picked from the main menu
+void startBenchmarkLevel()
+{
+	startLevel(game, benchmarkLevel);
+	markMazeDirty();
+	snapRenderState();
+}
+
+// Hold the scripted keys for this frame and fire at a fixed interval
+void applyBenchmarkInput(int frame)
+{
+	int scriptFrame = frame % BENCHMARK_SCRIPT_LENGTH;
+	for (int k = 0; k < BENCHMARK_SCRIPT_KEYS; k++)
+	{
+		gameInput.keys[benchmarkScript[k].key] = false;
+	}
+	for (int k = 0; k < BENCHMARK_SCRIPT_KEYS; k++)
+	{
+		if (scriptFrame >= benchmarkScript[k].start && scriptFrame < benchmarkScript[k].end)
+			gameInput.keys[benchmarkScript[k].key] = true;
+	}
+
+	if (frame % BENCHMARK_FIRE_INTERVAL == 0)
+		gameInput.push(InputEvent::FIRE);
+}
+
+// Percentile of sorted frame times
+double percentile(std::vector<double> &sorted, double p)
+{
+	int index = (int)(p * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+// Draw benchmarkFrames frames offscreen and print frame time statistics
+int runBenchmark()
+{
+	std::cout << "Benchmark: level " << benchmarkLevel << ", " << benchmarkFrames << " frames at "
+			  << screenWidth << "x" << screenHeight << std::endl;
+
+	// A replayed session supplies its own input from the main menu onwards
+	if (!replayingInput)
+		startBenchmarkLevel();
+
+	std::vector<double> frameTimes;
+	double drawCalls = 0.0;
+	double triangles = 0.0;
+	double binds = 0.0;
+	int restarts = 0;
+
+	for (int frame = 0; frame < BENCHMARK_WARMUP_FRAMES + benchmarkFrames && !replayFinished; frame++)
+	{
+		// Falling off or finishing the level restarts it so every frame renders gameplay
+		if (!replayingInput && (game.isGameOver || game.levelComplete || game.gameWon))
+		{
+			startBenchmarkLevel();
+			restarts++;
+		}
+		if (!replayingInput)
+			applyBenchmarkInput(frame);
+
+		// glFinish so the GPU work of the frame is inside the measurement
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		display();
+		glFinish();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (frame < BENCHMARK_WARMUP_FRAMES)
+			continue;
+
+		frameTimes.push_back(ms);
+		drawCalls += frameStats.drawCalls;
+		triangles += frameStats.triangles;
+		binds += frameStats.binds();
+	}
+
+	double mean = 0.0;
+	for (unsigned int i = 0; i < frameTimes.size(); i++)
+		mean += frameTimes[i];
+	mean /= frameTimes.size();
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	std::cout.setf(std::ios::fixed);
+	std::cout.precision(3);
+	std::cout << "Frame time ms: mean " << mean
+			  << "  p50 " << percentile(frameTimes, 0.50)
+			  << "  p95 " << percentile(frameTimes, 0.95)
+			  << "  p99 " << percentile(frameTimes, 0.99)
+			  << "  max " << frameTimes.back() << std::endl;
+	std::cout.precision(1);
+	std::cout << "Per frame: draw calls " << drawCalls / frameTimes.size()
+			  << "  triangles " << triangles / frameTimes.size()
+			  << "  binds " << binds / frameTimes.size() << std::endl;
+	std::cout << "Level restarts: " << restarts << std::endl;
+	if (audio.isRunning())
+		std::cout << audioMemoryReport() << std::endl;
+
+	// Clean-Up
+	audio.stop();
+	delete transformPool;
+	mainShader.destroy();
+	gpuProfiler.destroy();
+	if (instancingSupported)
+		instancedShader.destroy();
+	frameUniformBuffer.destroy();
+	glDeleteRenderbuffers(2, benchmarkRenderbuffers);
+	glDeleteFramebuffers(1, &benchmarkFramebuffer);
+
+	return 0;
+}
+
+/*-----------------------------------------------// Frustum Culling //-------------------------------------------------------------*/
+void updateFrustum()
+{
+	// Planes come from the same camera the scene is drawn with
+	Matrix4x4 viewProjection = Matrix4x4::multiply(ProjectionMatrix, ViewMatrix);
+	viewFrustum.extract(viewProjection);
+
+	// Reset the per-frame counters
+	for (int c = 0; c < CULL_CATEGORY_COUNT; c++)
+	{
+		cullTested[c] = 0;
+		cullRejected[c] = 0;
+	}
+}
+
+// Test a box and count the result - objects under a culled parent are rejected without a test
+bool isVisible(CullCategory category, Vector3f min, Vector3f max, bool parentVisible = true)
+{
+	cullTested[category]++;
+
+	if (!useFrustumCulling)
+		return true;
+
+	if (!parentVisible || !viewFrustum.intersectsAABB(min, max))
+	{
+		cullRejected[category]++;
+		return false;
+	}
+	return true;
+}
+
+// Box around a maze tile column between yMin and yMax, within its chunk's visibility
+bool isTileVisible(CullCategory category, int i, int j, float yMin, float yMax)
+{
+	bool chunkVisible = mazeChunkVisible[i / MAZE_CHUNK_SIZE][j / MAZE_CHUNK_SIZE];
+	return isVisible(category,
+					 Vector3f(i * 2.0f - 1.2f, yMin, j * 2.0f - 1.2f),
+					 Vector3f(i * 2.0f + 1.2f, yMax, j * 2.0f + 1.2f),
+					 chunkVisible);
+}
+
+/*-----------------------------------------------// Mesh Submission //-------------------------------------------------------------*/
+// Draw a mesh with the main shader, either now or sorted through the render queue
+void drawMesh(Mesh &mesh, GLuint texture, Matrix4x4 &modelView)
+{
+	if (useRenderQueue)
+	{
+		renderQueue.submit(mainShader.getID(), MVMatrixUniformLocation, texture, &mesh, modelView);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, modelView.getPtr());
+	mesh.Draw();
+
+	frameStats.textureBinds++;
+	frameStats.meshBinds++;
+	frameStats.drawCalls++;
+	frameStats.triangles += mesh.getTriangleCount();
 }
 
 /*-----------------------------------------------// Draw Maze Function //----------------------------------------------------------*/
 void DrawMaze()
 {
+	PROFILE_ZONE("DrawMaze");
+
+	// Chunk visibility - covers everything a tile can hold, from falling donuts up to coins
+	for (int ci = 0; ci < MAZE_CHUNKS_I; ci++)
+	{
+		for (int cj = 0; cj < MAZE_CHUNKS_J; cj++)
+		{
+			int lastI = std::min((ci + 1) * MAZE_CHUNK_SIZE, MAZE_HEIGHT) - 1;
+			int lastJ = std::min((cj + 1) * MAZE_CHUNK_SIZE, MAZE_WIDTH) - 1;
+			mazeChunkVisible[ci][cj] = isVisible(CULL_CHUNK,
+												 Vector3f(ci * MAZE_CHUNK_SIZE * 2.0f - 1.2f, -5.0f, cj * MAZE_CHUNK_SIZE * 2.0f - 1.2f),
+												 Vector3f(lastI * 2.0f + 1.2f, 2.5f, lastJ * 2.0f + 1.2f));
+		}
+	}
+
+	// Crates come from the baked chunk meshes when baking is enabled
+	bool baked = useBakedMaze;
+	if (baked)
+	{
+		DrawBakedMaze();
+	}
 
-	// Determine which tile the tank is currently on
-	int tankRow = (int)((tankPosition.x + 1.0f) / 2.0f);
-	int tankCol = (int)((tankPosition.z + 1.0f) / 2.0f);
+	// Gather every visible crate, shadow, coin and donut into the transform stage inputs
+	crateTransforms.clear();
+	shadowTransforms.clear();
+	coinTransforms.clear();
+	donutTransforms.clear();
 
 	// Loop through all tiles in the maze
 	for (int i = 0; i < MAZE_HEIGHT; i++)
 	{
 		for (int j = 0; j < MAZE_WIDTH; j++)
 		{
-			// Draw crate for floor (1) and coin tile (2)
-			if (MAZE[i][j] == 1 || MAZE[i][j] == 2)
+			// Crate for floor (1) and coin tile (2)
+			bool isCrate = (game.MAZE[i][j] == 1 || game.MAZE[i][j] == 2) && !baked;
+			if (isCrate && isTileVisible(CULL_CRATE, i, j, -1.0f, 1.0f))
 			{
-				// Apply Camera Manipluator to Set Model View Matrix on GPU
-				ModelViewMatrix.toIdentity();
-				Matrix4x4 m = cameraManip.apply(ModelViewMatrix);
-				glUniformMatrix4fv(
-					MVMatrixUniformLocation, // Uniform location
-					1,						 // Number of Uniforms
-					false,					 // Transpose Matrix
-					m.getPtr());			 // Pointer to Matrix Values
-
-				// Set Colour after program is in use
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, crateTexture);
-				glUniform1i(TextureMapUniformLocation, 0);
-
-				// First crate
-				m.translate(i * 2.0, 0.0f, j * 2.0);
-				glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, m.getPtr());
-				crateMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+				crateTransforms.add(i * 2.0f, 0.0f, j * 2.0f);
 			}
 
-			// Draw coin on top of tile 2
-			if (MAZE[i][j] == 2)
+			// Coin and its shadow share one box
+			if (game.MAZE[i][j] == 2 && isTileVisible(CULL_COIN, i, j, 1.3f, 2.5f))
 			{
-				// Set up transformation matrix
-				Matrix4x4 m = cameraManip.apply(ModelViewMatrix);
+				// Shadow slightly above the floor, flat and wide
+				shadowTransforms.add(i * 2.0f, 1.4f, j * 2.0f, renderState.coinRotation, 0.3f, 0.01f, 0.3f);
 
-				// 1. Draw shadow
-				{
-					Matrix4x4 shadowMatrix = m;
-					shadowMatrix.translate(i * 2.0, 1.4f, j * 2.0); // Slightly above the floor
-					shadowMatrix.scale(0.3f, 0.01f, 0.3f);			// Flat and wide
-					shadowMatrix.rotate(coinRotationAngle, 0.0f, 1.0f, 0.0f);
-
-					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, shadowTexture); // Or shadow texture
-					glUniform1i(TextureMapUniformLocation, 0);
-
-					glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, shadowMatrix.getPtr());
-					shadowMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
-				}
-
-				// 2. Draw animated bouncing and rotating coin
-				float bounceHeight = 0.1f * sin(coinBounce);
-				m.translate(i * 2.0, 2.0f + bounceHeight, j * 2.0);
-				m.scale(0.3f, 0.3f, 0.3f);
-				m.rotate(coinRotationAngle, 0.0f, 1.0f, 0.0f);
-				glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, m.getPtr());
-
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, coinTexture);
-				glUniform1i(TextureMapUniformLocation, 0);
-				coinMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+				// Animated bouncing and rotating coin
+				float bounceHeight = 0.1f * sin(renderState.coinBounce);
+				coinTransforms.add(i * 2.0f, 2.0f + bounceHeight, j * 2.0f, renderState.coinRotation, 0.3f, 0.3f, 0.3f);
 			}
 
-			// Draw a dount tile (3) with shake and fall animation
-			if (MAZE[i][j] == 3)
+			// Dount tile (3) with shake and fall animation
+			if (game.MAZE[i][j] == 3)
 			{
-				Matrix4x4 m = cameraManip.apply(ModelViewMatrix);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, donutTexture);
-				glUniform1i(TextureMapUniformLocation, 0);
-
-				std::pair<int, int> key = std::make_pair(i, j);
-				int fallFrame = donutFallTimers[key];
-
-				// If the tank is on this tile, start shaking/falling
-				if (tankRow == i && tankCol == j && isOnGround)
-				{
-					fallFrame++;
-					donutFallTimers[key] = fallFrame;
-				}
-				else if (fallFrame > 0)
-				{
-					fallFrame++;
-					donutFallTimers[key] = fallFrame;
-				}
+				// Fall timers are advanced by updateDonuts in the simulation step
+				std::map<std::pair<int, int>, float>::iterator timer = game.donutFallTimers.find(std::make_pair(i, j));
+				float fallTime = timer != game.donutFallTimers.end() ? timer->second : 0.0f;
 
-				// Shake tile for first 35 frames
+				// Shake tile for the first 35/60 of a second
+				const float shakeSeconds = 35.0f / 60.0f;
 				float shakeOffset = 0.0f;
 				float dropOffset = 0.0f;
-				if (fallFrame > 0 && fallFrame < 35)
+				if (fallTime > 0.0f && fallTime < shakeSeconds)
 				{
-					shakeOffset = 0.1f * sin(fallFrame * 0.5f);
+					shakeOffset = 0.1f * sin(fallTime * 30.0f);
 				}
-				else if (fallFrame >= 35)
+				else if (fallTime >= shakeSeconds)
 				{
-					dropOffset = -((fallFrame - 35) * 0.05f); // Begin to fall
+					dropOffset = -((fallTime - shakeSeconds) * 3.0f); // Begin to fall
 				}
 
-				// After 100 frames, delete the tile
-				if (fallFrame >= 100)
-				{
-					MAZE[i][j] = 0;
-					donutFallTimers.erase(key);
-					continue; // skip drawing
-				}
+				if (isTileVisible(CULL_DONUT, i, j, dropOffset - 1.0f, 1.0f))
+					donutTransforms.add(i * 2.0f + shakeOffset, dropOffset, j * 2.0f);
+			}
+		}
+	}
 
-				// Apply translation for animation
-				m.translate(i * 2.0 + shakeOffset, dropOffset, j * 2.0);
-				glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, m.getPtr());
-				donutMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+	// Instanced: model matrices written straight into the instance buffers and submitted as one draw per batch
+	bool instanced = useInstancing && instancingSupported;
+	if (instanced)
+	{
+		crateInstances.clear();
+		shadowInstances.clear();
+		coinInstances.clear();
+		donutInstances.clear();
+		{
+			PROFILE_ZONE("MazeTransforms");
+			crateTransforms.compute(crateInstances.allocate(crateTransforms.size()), NULL, transformPool);
+			shadowTransforms.compute(shadowInstances.allocate(shadowTransforms.size()), NULL, transformPool);
+			coinTransforms.compute(coinInstances.allocate(coinTransforms.size()), NULL, transformPool);
+			donutTransforms.compute(donutInstances.allocate(donutTransforms.size()), NULL, transformPool);
+		}
+		DrawMazeInstances();
+		return;
+	}
+
+	// Per tile: the whole batch premultiplied by the view, then one draw each
+	drawTransformBatch(crateTransforms, crateMesh, crateTexture);
+	drawTransformBatch(shadowTransforms, shadowMesh, shadowTexture);
+	drawTransformBatch(coinTransforms, coinMesh, coinTexture);
+	drawTransformBatch(donutTransforms, donutMesh, donutTexture);
+}
+
+void drawTransformBatch(TransformBatch &transforms, Mesh &mesh, GLuint texture)
+{
+	if (transforms.size() == 0)
+		return;
+
+	mazeTransforms.resize(transforms.size());
+	{
+		PROFILE_ZONE("MazeTransforms");
+		transforms.compute(&mazeTransforms[0], &ViewMatrix, transformPool);
+	}
+	for (size_t t = 0; t < mazeTransforms.size(); t++)
+		drawMesh(mesh, texture, mazeTransforms[t]);
+}
+
+/*-----------------------------------------------// Draw Baked Maze Function //-----------------------------------------------------*/
+void rebuildMazeChunk(int ci, int cj)
+{
+	// Collect the world transform of every crate tile in the chunk
+	std::vector<Matrix4x4> transforms;
+	for (int i = ci * MAZE_CHUNK_SIZE; i < (ci + 1) * MAZE_CHUNK_SIZE && i < MAZE_HEIGHT; i++)
+	{
+		for (int j = cj * MAZE_CHUNK_SIZE; j < (cj + 1) * MAZE_CHUNK_SIZE && j < MAZE_WIDTH; j++)
+		{
+			if (game.MAZE[i][j] == 1 || game.MAZE[i][j] == 2)
+			{
+				Matrix4x4 model;
+				model.translate(i * 2.0, 0.0f, j * 2.0);
+				transforms.push_back(model);
 			}
 		}
 	}
+
+	mazeChunkMeshes[ci][cj].initMerged(crateMesh, transforms);
+	mazeChunkDirty[ci][cj] = false;
+}
+
+void DrawBakedMaze()
+{
+	// Geometry is already in world space, so only the camera transform is needed
+	Matrix4x4 m = ViewMatrix;
+
+	for (int ci = 0; ci < MAZE_CHUNKS_I; ci++)
+	{
+		for (int cj = 0; cj < MAZE_CHUNKS_J; cj++)
+		{
+			// Dirty chunks are rebuilt even when off screen so they are ready when they come into view
+			if (mazeChunkDirty[ci][cj])
+				rebuildMazeChunk(ci, cj);
+
+			// Chunks with every crate gone have nothing to draw
+			if (!mazeChunkVisible[ci][cj] || mazeChunkMeshes[ci][cj].getTriangleCount() == 0)
+				continue;
+
+			drawMesh(mazeChunkMeshes[ci][cj], crateTexture, m);
+		}
+	}
+}
+
+/*-----------------------------------------------// Draw Maze Instances Function //-------------------------------------------------*/
+void drawInstanceBatch(InstanceBuffer &instances, Mesh &mesh, GLuint texture)
+{
+	if (instances.size() == 0)
+		return;
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	frameStats.textureBinds++;
+	frameStats.meshBinds++;
+	frameStats.drawCalls++;
+	frameStats.triangles += mesh.getTriangleCount() * instances.size();
+	instances.upload();
+	mesh.DrawInstanced(instances, instanceMatrixAttribute);
+}
+
+void DrawMazeInstances()
+{
+	// View matrix is shared by every instance, model matrices come from the instance buffers
+	instancedShader.use();
+	frameStats.programBinds++;
+	glUniformMatrix4fv(InstancedViewUniformLocation, 1, false, ViewMatrix.getPtr());
+
+	drawInstanceBatch(crateInstances, crateMesh, crateTexture);
+	drawInstanceBatch(shadowInstances, shadowMesh, shadowTexture);
+	drawInstanceBatch(coinInstances, coinMesh, coinTexture);
+	drawInstanceBatch(donutInstances, donutMesh, donutTexture);
+
+	// Restore the main shader for the rest of the scene
+	mainShader.use();
+	frameStats.programBinds++;
 }
 
 /*------------------------------------------------// Draw Tank Function //---------------------------------------------------------*/
 void DrawTank(float x, float y, float z)
 {
+	PROFILE_ZONE("DrawTank");
+
+	// Conservative box around the scaled tank, including the fall rotation
+	Vector3f position = renderState.tankPosition;
+	if (!isVisible(CULL_TANK,
+				   Vector3f(position.x - 2.0f, position.y - 2.0f, position.z - 2.0f),
+				   Vector3f(position.x + 2.0f, position.y + 3.0f, position.z + 2.0f)))
+		return;
+
 	// Start with the base ModelView matrix transformed by the camera
-	Matrix4x4 m = cameraManip.apply(ModelViewMatrix);
+	Matrix4x4 m = ViewMatrix;
 
 	// Apply tank world position, rotation, and scale
-	m.translate(tankPosition.x, tankPosition.y, tankPosition.z);
-	m.rotate(tankRotation, 0.0f, 1.0f, 0.0f); // Rotate the tank around Y-axis
+	m.translate(position.x, position.y, position.z);
+	m.rotateY(renderState.tankRotation); // Rotate the tank around Y-axis
 	m.scale(0.3f, 0.3f, 0.3f);				  // Scale tank to appropriate size
-	if (isfalling || fallRotation > 0.0f)
+	if (game.isfalling || renderState.fallRotation > 0.0f)
 	{
-		m.rotate(fallRotation, 1.0f, 0.0f, 0.0f);
+		m.rotateX(renderState.fallRotation);
 	}
 
-	// Bind the tank texture and pass it to the shader
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, tankTexture);
-	glUniform1i(TextureMapUniformLocation, 0);
-
 	/*-------------------------------------------------// Draw Chassis //--------------------------------------------------------------*/
 	m.translate(x, y, z); // Apply offset to base transformation
-	glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, m.getPtr());
-	chassisMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+	drawMesh(chassisMesh, tankTexture, m);
 
 	/*-------------------------------------------------// Draw Turret //---------------------------------------------------------------*/
 	Matrix4x4 turretMatrix = m;
 	turretMatrix.translate(0.0f, 0.0f, 0.0f);				   // Relative to chassis center
-	turretMatrix.rotate(turretBaseRotation, 0.0f, 1.0f, 0.0f); // Yaw rotation
-	glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, turretMatrix.getPtr());
-	turretMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+	turretMatrix.rotateY(renderState.turretRotation); // Yaw rotation
+	drawMesh(turretMesh, tankTexture, turretMatrix);
+
+	// Both wheel pairs share the roll, and the back steering is the front steering reversed,
+	// so steer then roll is composed from two rotations for both
+	Quaternion steer = Quaternion::rotationY(renderState.steeringAngle);
+	Quaternion roll = Quaternion::rotationX(renderState.wheelRotation);
 
 	/*-------------------------------------------------// Draw Front Wheeels //--------------------------------------------------------*/
 	Matrix4x4 frontWheelMatrix = m;
 	frontWheelMatrix.translate(-0.1f, 1.0f, 2.2f);			  // Position in front of chassis center
-	frontWheelMatrix.rotate(steeringAngle, 0.0f, 1.0f, 0.0f); // Steering wheels
-	frontWheelMatrix.rotate(wheelRotation, 1.0f, 0.0f, 0.0f); // Rolling wheels
-	glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, frontWheelMatrix.getPtr());
-	frontWheelMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+	frontWheelMatrix.rotate(steer * roll);	  // Steering, then rolling wheels
+	drawMesh(frontWheelMesh, tankTexture, frontWheelMatrix);
 
 	/*-------------------------------------------------// Draw Back Wheels //----------------------------------------------------------*/
 	Matrix4x4 backWheelMatrix = m;
 	backWheelMatrix.translate(-0.1f, 1.1f, -1.3f);			  // Position behind chassis
-	backWheelMatrix.rotate(-steeringAngle, 0.0f, 1.0f, 0.0f); // Opposite back wheel steering
-	backWheelMatrix.rotate(wheelRotation, 1.0f, 0.0f, 0.0f);  // Rolling effect
-	glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, backWheelMatrix.getPtr());
-	backWheelMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+	backWheelMatrix.rotate(steer.conjugate() * roll); // Opposite back wheel steering, then rolling effect
+	drawMesh(backWheelMesh, tankTexture, backWheelMatrix);
 }
 
-/*------------------------------------------------// Draw Ball //-------------------------------------------------------------------*/
-void DrawBall(float x, float y, float z)
+/*------------------------------------------------// Draw Balls //------------------------------------------------------------------*/
+void DrawBalls()
 {
-	// Skip drawing if the ball isn't active or hasn't been fired yet
-	if (!ballActive || !isBallFired)
-		return;
+	bool instanced = useInstancing && instancingSupported;
+	ballInstances.clear();
 
-	// Update ball rotation angle over time (rolling animation)
-	ballRotationAngle += 270.0f * deltaTime; // 270 degrees per second
+	for (int slot = 0; slot < ProjectilePool::CAPACITY; slot++)
+	{
+		// Skip free slots and balls off screen
+		if (renderState.ballSerials[slot] == 0)
+			continue;
+		Vector3f position = renderState.ballPositions[slot];
+		if (!isVisible(CULL_BALL,
+					   Vector3f(position.x - 0.3f, position.y - 0.3f, position.z - 0.3f),
+					   Vector3f(position.x + 0.3f, position.y + 0.3f, position.z + 0.3f)))
+			continue;
+
+		// Model transform for the instance buffer, or model-view for a single draw
+		Matrix4x4 m;
+		if (!instanced)
+			m = ViewMatrix;
+		m.translate(position.x, position.y, position.z); // Position the ball
+		m.scale(0.18f, 0.18f, 0.18f);					 // Scale to appropriate size
+		m.rotateX(renderState.ballRotations[slot]);		 // Roll along X-axis (forward spin)
+
+		if (instanced)
+			ballInstances.add(m);
+		else
+			drawMesh(ballMesh, ballTexture, m);
+	}
 
-	// Keep the angle within 0-360 degrees
-	if (ballRotationAngle > 360.0f)
-		ballRotationAngle -= 360.0f;
+	// Every ball in flight in one instanced draw
+	if (instanced && ballInstances.size() > 0)
+	{
+		instancedShader.use();
+		frameStats.programBinds++;
+		glUniformMatrix4fv(InstancedViewUniformLocation, 1, false, ViewMatrix.getPtr());
 
-	// Build the transformation matrix
-	Matrix4x4 m = cameraManip.apply(ModelViewMatrix); // Start with camera-alinged modelview
-	m.translate(ballPosX, ballPosY, ballPosZ);		  // Position the ball
-	m.scale(0.18f, 0.18f, 0.18f);					  // Scale to appropriate size
-	m.rotate(ballRotationAngle, 1.0f, 0.0f, 0.0f);	  // Roll along X-axis (forward spin)
+		drawInstanceBatch(ballInstances, ballMesh, ballTexture);
 
-	// Bind the ball texture
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, ballTexture);
-	glUniformMatrix4fv(MVMatrixUniformLocation, 1, false, m.getPtr());
-	ballMesh.Draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexcoordAttribute);
+		mainShader.use();
+		frameStats.programBinds++;
+	}
 }
 
 /*----------------------------------------------// Render Particles //----------------------------------------------*/
 void drawParticles()
 {
-	// If particle system is not active, skip rendering
-	if (!spawnParticles)
+	PROFILE_ZONE("drawParticles");
+
+	// If no burst is going, skip rendering
+	const ParticlePool &particles = game.particles;
+	if (particles.size() == 0)
 		return;
 
 	// Disable lighting so particles aren't affected by scene lighting
@@ -1629,14 +1758,16 @@ void drawParticles()
 	glPointSize(4.0f);
 	glBegin(GL_POINTS);
 
-	// Iterate over all particles and render active ones
-	for (const auto &p : particles)
+	// Particles move in straight lines, so stepping back along the velocity interpolates exactly
+	float rewind = (1.0f - renderState.alpha) * deltaTime;
+
+	// Only live particles are kept, packed at the front of the pool
+	for (int p = 0; p < particles.size(); p++)
 	{
-		if (p.life > 0.0f) // Only draw if particles are still alive
-		{
-			glColor4f(1.0f, 0.0f, 0.2f, p.life);				  // Fades with life
-			glVertex3f(p.position.x, p.position.y, p.position.z); // Position in 3D space
-		}
+		glColor4f(1.0f, 0.0f, 0.2f, particles.life[p]); // Fades with life
+		glVertex3f(particles.positionX[p] - particles.velocityX[p] * rewind,
+				   particles.positionY[p] - particles.velocityY[p] * rewind,
+				   particles.positionZ[p] - particles.velocityZ[p] * rewind); // Position in 3D space
 	}
 	glEnd();
 	// Reset colour to white (avoid affecting other draws)
@@ -1726,6 +1857,8 @@ void drawTextBox(float x, float y, float width, float height, float r, float g,
 
 void drawHUD()
 {
+	PROFILE_ZONE("drawHUD");
+
 	const int padding = 20;
 	const int extraPadding = 30;
 	const int charWidth = 8;
@@ -1746,20 +1879,20 @@ void drawHUD()
 
 	/*---------------------------------------------|| Render Text ||---------------------------------------------------------------*/
 	/*-----------------------------------|| HUD DURING GAMEPLAY ||-------------------------------------------------------------*/
-	if (mainMenu == 0)
+	if (game.mainMenu == 0)
 	{
-		if (!gameWon)
+		if (!game.gameWon)
 		{
 			// --- Top-Left: Level & Coin Status ---
-			std::string levelText = "Level: " + std::to_string(currentLevel);
-			std::string coinText = "Coins: " + std::to_string(coinsCollected) + "/" + std::to_string(totalCoins);
+			std::string levelText = "Level: " + std::to_string(game.currentLevel);
+			std::string coinText = "Coins: " + std::to_string(game.coinsCollected) + "/" + std::to_string(game.totalCoins);
 			std::string statusText = levelText + "   " + coinText;
 			int statusWidth = charWidth * statusText.length();
 			drawTextBox(10, screenHeight - 40, statusWidth + 2 * padding, statusBoxHeight, 1.0f, 1.0f, 1.0f, 0.8);
 			render2dText(statusText, 1.0f, 1.0f, 1.0f, 10 + padding, screenHeight - 28);
 
 			// --- Top-Right: Time ---
-			std::string timeText = "Time: " + std::to_string(static_cast<int>(remainingTime)) + "s";
+			std::string timeText = "Time: " + std::to_string(static_cast<int>(game.remainingTime)) + "s";
 			int timeWidth = charWidth * timeText.length();
 			drawTextBox(screenWidth - timeWidth - 2 * padding - 10, screenHeight - 40, timeWidth + 2 * padding, statusBoxHeight, 1.0f, 1.0f, 1.0f, 0.8);
 			render2dText(timeText, 1.0f, 1.0f, 1.0f, screenWidth - timeWidth - padding - 10, screenHeight - 28);
@@ -1772,9 +1905,9 @@ void drawHUD()
 		}
 	}
 	/*----------------------------------------|| GAME OVER SCREEN ||-------------------------*/
-	if (isGameOver)
+	if (game.isGameOver)
 	{
-		if (!gameWon)
+		if (!game.gameWon)
 		{
 			std::string gameOverText = "GAME OVER";
 			std::string resetText = "Press R to Reset or Q to Quit";
@@ -1793,13 +1926,13 @@ void drawHUD()
 	}
 
 	/*------------------------------------------|| Pause MENU ||----------------------------------------*/
-	if (showMenu)
+	if (game.showMenu)
 	{
 		std::string title = "PAUSED - Select Level";
 
 		// Display unlock status based on previous level completion
-		std::string level2Text = levelCompleted[0] ? "2: Level 2 (unlocked)" : "2: Level 2 (locked)";
-		std::string level3Text = (levelCompleted[0] && levelCompleted[1]) ? "3: Level 3 (unlocked)" : "3: Level 3 (locked)";
+		std::string level2Text = game.levelCompleted[0] ? "2: Level 2 (unlocked)" : "2: Level 2 (locked)";
+		std::string level3Text = (game.levelCompleted[0] && game.levelCompleted[1]) ? "3: Level 3 (unlocked)" : "3: Level 3 (locked)";
 
 		std::string options =
 			"1: Level 1    " + level2Text + "     " + level3Text + "\n"
@@ -1818,7 +1951,7 @@ void drawHUD()
 	}
 
 	/*---------------------------------------|| MAIN MENU ||-------------------------------------------------*/
-	if (mainMenu)
+	if (game.mainMenu)
 	{
 
 		std::string title = "Andreas Tank Game - Select Level";
@@ -1826,8 +1959,8 @@ void drawHUD()
 		int winWidth = 795;
 		int boxHeight = 95;
 		// Dynamic level text based on completion
-		std::string level2Text = levelCompleted[0] ? "2: Level 2 (unlocked)" : "2: Level 2 (locked)";
-		std::string level3Text = (levelCompleted[0] && levelCompleted[1]) ? "3: Level 3 (unlocked)" : "3: Level 3 (locked)";
+		std::string level2Text = game.levelCompleted[0] ? "2: Level 2 (unlocked)" : "2: Level 2 (locked)";
+		std::string level3Text = (game.levelCompleted[0] && game.levelCompleted[1]) ? "3: Level 3 (unlocked)" : "3: Level 3 (locked)";
 
 		std::string options =
 			"1: Level 1    " + level2Text + "     " + level3Text + "\n"
@@ -1849,7 +1982,7 @@ void drawHUD()
 		render2dText("R: Restart            Q: Quit Game", 0.8f, 0.8f, 0.8f, centerX - 120, centerY - 10);
 	}
 
-	if (levelComplete && !gameWon)
+	if (game.levelComplete && !game.gameWon)
 	{
 		std::string winText = "Level Complete!";
 		std::string subText = "Press N to continue to the next level.";
@@ -1865,7 +1998,7 @@ void drawHUD()
 		drawTextBox(centerX - winWidth / 2, centerY - 22, winWidth, boxHeight, 0.0f, 0.0f, 0.0f, 8.0f);
 		render2dText(winText, 1.0f, 1.0f, 1.0f, centerX - winText.length() * 10 + 80, centerY + 40);
 		render2dText(subText, 1.0f, 1.0f, 1.0f, centerX - subText.length() * 5 + 40, centerY);
-	} else if (gameWon)
+	} else if (game.gameWon)
 	{
 		/*------------------------------------------|| VICTORY SCREEN ||---------------------------------------*/
 		std::string winText = "CONGRATULATIONS!";
@@ -1887,7 +2020,7 @@ void drawHUD()
 		render2dText(instructionText, 1.0f, 1.0f, 1.0f, centerX - instructionText.length() - 90, centerY);
 	}
 
-	if (LowTimeWarning && !gameWon && !isGameOver)
+	if (game.LowTimeWarning && !game.gameWon && !game.isGameOver)
 	{
 		std::string warnText = "HURRY UP!";
 		std::string subText = "Only 100 seconds left!";
@@ -1899,15 +2032,21 @@ void drawHUD()
 		int centerY = screenHeight - 150; // Position it higher so it doesn't overlap other UI
 
 		// Red border
-		drawBorderBox(centerX - boxWidth / 2, centerY - 22, boxWidth, boxHeight, 1.0f, 0.0f, 0.0f, 1.0f, flashAlpha);
+		drawBorderBox(centerX - boxWidth / 2, centerY - 22, boxWidth, boxHeight, 1.0f, 0.0f, 0.0f, 1.0f, game.flashAlpha);
 
 		// Inner red-transparent box
-		drawTextBox(centerX - boxWidth / 2, centerY - 22, boxWidth, boxHeight, 1.0f, 0.0f, 0.0f, flashAlpha);
+		drawTextBox(centerX - boxWidth / 2, centerY - 22, boxWidth, boxHeight, 1.0f, 0.0f, 0.0f, game.flashAlpha);
 
 		render2dText(warnText, 1.0f, 1.0f, 1.0f, centerX - warnText.length() * 5, centerY + 40);
 		render2dText(subText, 1.0f, 1.0f, 1.0f, centerX - subText.length() - 65, centerY + 15);
 	}
 
+	// Performance counters
+	if (showStats)
+	{
+		drawStats();
+	}
+
 	// Restore OpenGL states
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_LIGHTING);
@@ -1918,9 +2057,88 @@ void drawHUD()
 	glPopMatrix();
 }
 
+/*------------------------------------------------// Performance Overlay //-------------------------------------------------------*/
+void drawStats()
+{
+	std::vector<std::string> lines;
+
+	std::ostringstream frame;
+	frame.setf(std::ios::fixed);
+	frame.precision(2);
+	frame << "Frame: " << frameTimeMs << " ms";
+	lines.push_back(frame.str());
+
+	// GPU time per pass, a few frames behind the CPU
+	if (gpuProfiler.isSupported())
+	{
+		std::ostringstream gpu;
+		gpu.setf(std::ios::fixed);
+		gpu.precision(2);
+		gpu << "GPU ms:";
+		for (int p = 0; p < gpuProfiler.getPassCount(); p++)
+		{
+			gpu << "  " << gpuProfiler.getPassName(p) << " " << gpuProfiler.getPassMs(p);
+		}
+		lines.push_back(gpu.str());
+	}
+
+	// Culled / tested per category this frame
+	std::ostringstream culled;
+	culled << "Culled" << (useFrustumCulling ? "" : " (off)") << ":";
+	for (int c = 0; c < CULL_CATEGORY_COUNT; c++)
+	{
+		culled << "  " << cullCategoryNames[c] << " " << cullRejected[c] << "/" << cullTested[c];
+	}
+	lines.push_back(culled.str());
+
+	// State changes actually issued this frame - toggle O to compare with the unsorted path
+	std::ostringstream binds;
+	binds << "Draws: " << frameStats.drawCalls << "  Tris: " << frameStats.triangles << "  Binds: " << frameStats.binds()
+		  << " (program " << frameStats.programBinds << ", texture " << frameStats.textureBinds
+		  << ", mesh " << frameStats.meshBinds << ")" << (useRenderQueue ? "  queue on" : "  queue off");
+	lines.push_back(binds.str());
+
+	// Coin bursts - live particles, and what the last step's update of all of them cost
+	std::ostringstream particles;
+	particles.setf(std::ios::fixed);
+	particles.precision(1);
+	particles << "Particles: " << game.particles.size() << "/" << ParticlePool::CAPACITY
+			  << "  update " << game.particles.getUpdateNanoseconds() / 1000.0 << " us"
+			  << "  dropped " << game.particles.getDroppedCount();
+	lines.push_back(particles.str());
+
+	// Reading /proc/self/smaps takes a while, so the figure is refreshed once a second
+	if (audio.isRunning())
+	{
+		static std::string audioLine;
+		static std::chrono::steady_clock::time_point audioLineTime;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (audioLine.empty() || now - audioLineTime > std::chrono::seconds(1))
+		{
+			std::ostringstream voices;
+			voices << "  Voices: " << audio.getActiveVoices();
+			audioLine = audioMemoryReport() + voices.str();
+			audioLineTime = now;
+		}
+		lines.push_back(audioLine);
+	}
+
+	const int lineHeight = 22;
+	int top = screenHeight - 70;
+	drawTextBox(10, top - lineHeight * (int)lines.size() + 12, 640, lineHeight * lines.size() + 4, 1.0f, 1.0f, 1.0f, 0.6f);
+	for (unsigned int i = 0; i < lines.size(); i++)
+	{
+		render2dText(lines[i], 1.0f, 1.0f, 0.0f, 20, top - lineHeight * i);
+	}
+}
+
 /*------------------------------------------------// Set Up Render 2d Text Function //---------------------------------------------*/
 void render2dText(std::string text, float r, float g, float b, float x, float y)
 {
+	// GLUT bitmap fonts need a GLUT window
+	if (!hasWindow)
+		return;
+
 	glColor3f(r, g, b);	 // Set text Colour
 	glRasterPos2f(x, y); // Set position in window coordinates
 
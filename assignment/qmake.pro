@@ -2,7 +2,7 @@ TEMPLATE = app
 
 #Executable Name
 TARGET = Assignment
-CONFIG = debug
+CONFIG = debug thread
 
 #Destination
 DESTDIR = .
@@ -12,24 +12,56 @@ HEADERS	+= 	../common/Shader.h	    	\
 		../common/Vector.h		        \	
 		../common/Matrix.h		        \
 		../common/Mesh.h		        \
+        ../common/VertexAttributes.h    \
         ../common/Texture.h             \		
+        ../common/InstanceBuffer.h      \
+        ../common/TransformBatch.h      \
+        ../common/ThreadPool.h          \
+        ../common/Frustum.h             \
+        ../common/RenderQueue.h         \
+        ../common/Profiler.h            \
+        ../common/GpuProfiler.h         \
+        ../common/InputLog.h            \
+        ../common/SpscQueue.h           \
+        ../common/AudioBackend.h        \
+        ../common/AudioEngine.h         \
+        ../simulation/GameState.h       \
+        ../simulation/ProjectilePool.h  \
+        ../simulation/ParticlePool.h    \
+        ../simulation/GridTraversal.h   \
         ../common/SphericalCameraManipulator.h   \
 
 #Sources
 SOURCES += 	main.cpp			        \
   		../common/Shader.cpp		    \
-		../common/Vector.cpp		    \
 		../common/Matrix.cpp		    \
 		../common/Mesh.cpp		        \
         ../common/Texture.cpp           \
+        ../common/InstanceBuffer.cpp    \
+        ../common/TransformBatch.cpp    \
+        ../common/ThreadPool.cpp        \
+        ../common/Frustum.cpp           \
+        ../common/RenderQueue.cpp       \
+        ../common/Profiler.cpp          \
+        ../common/GpuProfiler.cpp       \
+        ../common/InputLog.cpp          \
+        ../common/AudioBackend.cpp      \
+        ../common/AudioEngine.cpp       \
+        ../simulation/GameState.cpp     \
+        ../simulation/ProjectilePool.cpp \
+        ../simulation/ParticlePool.cpp  \
+        ../simulation/GridTraversal.cpp \
         ../common/SphericalCameraManipulator.cpp \
 
 INCLUDEPATH += 	./ 				    \
 		        ../common/ 			\
+		        ../simulation/ 		\
 
 		
 #Library Libraries
 LIBS +=	-lGLEW			    	    	        \
 	-lglut			        		\
 	-lGLU						\
-        -lGL             	                  	\  
+        -lGL             	                  	\
+        -lEGL                           \
+        -lpthread                       \  
@@ -1,10 +1,18 @@
 #version 120
+#extension GL_ARB_uniform_buffer_object : require
+
+// Per-frame constants, uploaded once per frame (binding point 0)
+layout(std140) uniform FrameUniforms
+{
+   mat4  ProjMatrix_uniform;
+   vec4  LightPosition_uniform;
+   vec4  Ambient_uniform;
+   vec4  Specular_uniform;
+   float SpecularPower_uniform;
+   float brightness;
+};
 
-uniform vec4        Ambient_uniform;
-uniform vec4        Specular_uniform;
-uniform float       SpecularPower_uniform;
 uniform sampler2D   Texture_uniform;
-uniform float       brightness;
 
 varying vec3    ViewDirection;
 varying vec3    LightDirection;
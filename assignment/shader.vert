@@ -1,4 +1,16 @@
 #version 120
+#extension GL_ARB_uniform_buffer_object : require
+
+// Per-frame constants, uploaded once per frame (binding point 0)
+layout(std140) uniform FrameUniforms
+{
+   mat4  ProjMatrix_uniform;
+   vec4  LightPosition_uniform;
+   vec4  Ambient_uniform;
+   vec4  Specular_uniform;
+   float SpecularPower_uniform;
+   float brightness;
+};
 
 // Attributes
 attribute vec3 aVertexPosition;
@@ -6,8 +18,6 @@ attribute vec3 aVertexNormal;
 attribute vec2 aVertexTexcoord;
 
 uniform mat4x4 MVMatrix_uniform;
-uniform mat4x4 ProjMatrix_uniform;
-uniform vec3   LightPosition_uniform;
 
 varying vec3 ViewDirection;
 varying vec3 LightDirection;
@@ -19,7 +29,7 @@ void main( void )
    texCoord = aVertexTexcoord;
 
    ViewDirection  = -vec3(MVMatrix_uniform * vec4(aVertexPosition, 1.0));
-   LightDirection = LightPosition_uniform;
+   LightDirection = LightPosition_uniform.xyz;
    Normal         = (MVMatrix_uniform * vec4(aVertexNormal,0.0)).xyz;  
 
    gl_Position = ProjMatrix_uniform * MVMatrix_uniform * vec4(aVertexPosition,1.0);
@@ -0,0 +1,39 @@
+#version 120
+#extension GL_ARB_uniform_buffer_object : require
+
+// Per-frame constants, uploaded once per frame (binding point 0)
+layout(std140) uniform FrameUniforms
+{
+   mat4  ProjMatrix_uniform;
+   vec4  LightPosition_uniform;
+   vec4  Ambient_uniform;
+   vec4  Specular_uniform;
+   float SpecularPower_uniform;
+   float brightness;
+};
+
+// Attributes
+attribute vec3 aVertexPosition;
+attribute vec3 aVertexNormal;
+attribute vec2 aVertexTexcoord;
+attribute mat4 aInstanceMatrix;		// Per-instance model matrix (divisor 1)
+
+uniform mat4x4 ViewMatrix_uniform;
+
+varying vec3 ViewDirection;
+varying vec3 LightDirection;
+varying vec3 Normal;
+varying vec2 texCoord;
+
+void main( void )
+{
+   mat4 MVMatrix = ViewMatrix_uniform * aInstanceMatrix;
+
+   texCoord = aVertexTexcoord;
+
+   ViewDirection  = -vec3(MVMatrix * vec4(aVertexPosition, 1.0));
+   LightDirection = LightPosition_uniform.xyz;
+   Normal         = (MVMatrix * vec4(aVertexNormal,0.0)).xyz;  
+
+   gl_Position = ProjMatrix_uniform * MVMatrix * vec4(aVertexPosition,1.0);
+}
@@ -0,0 +1,436 @@
+/*=================================================================================================================================*/
+/*-------------------------------------------------------// Start //---------------------------------------------------------------*/
+/*=================================================================================================================================*/
+// Headless batch of simulated playthroughs for level balancing - no window, GL or sound
+// Usage: ./Batch [--runs n] [--threads n] [--level n] [--agent seek|random] [--noise p] [--seed n] [--maze file] [--step-rate hz] [--scaling]
+#include <GameState.h>
+#include <GridTraversal.h>
+#include <ThreadPool.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+
+/*---------------------------------------------------// Function Prototypes //-----------------------------------------------------*/
+struct RunResult;
+RunResult runSimulation(const GameState &levels, int run);
+double runBatch(ThreadPool &pool, const GameState &levels, std::vector<RunResult> &results);
+void reportLevels(const std::vector<RunResult> &results);
+void reportScaling(const GameState &levels);
+uint64_t hashResults(const std::vector<RunResult> &results);
+
+/*----------------------------------------------------// Global Variables //-------------------------------------------------------*/
+// Options - read once in main, never written while the batch runs
+int runCount = 3000;
+int maxThreads = 0;		 // 0 = every hardware thread
+int onlyLevel = 0;		 // 0 = runs are spread over every level
+bool useRandomAgent = false; // Default agent walks to the nearest coin
+float agentNoise = 0.0005f; // Chance per step that the seeking agent does something random instead
+unsigned int baseSeed = 1;
+std::string mazeFile = "../assignment/maze.txt";
+bool measureScaling = false;
+int stepRate = 60; // Steps per simulated second - tile collisions are swept, so coarser steps still catch every tile
+
+// Set from the step rate
+float stepSeconds = 1.0f / 60.0f;
+int maxSteps = 13000; // Level timer runs out after 200 s, 12000 steps at 60 Hz
+
+// How a run ended
+enum Outcome
+{
+	COMPLETED,
+	FELL,
+	TIMED_OUT,
+	STEP_LIMIT,
+	OUTCOME_COUNT
+};
+
+// One playthrough - each task writes only its own slot
+struct RunResult
+{
+	int level;
+	Outcome outcome;
+	float seconds; // Simulated time until the run ended
+	int coins;	   // Coins picked up by the tank or the ball
+	int totalCoins;
+};
+
+// Main Program Entry
+int main(int argc, char **argv)
+{
+	// Command line options
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (option == "--runs" && i + 1 < argc)
+			runCount = std::max(1, atoi(argv[++i]));
+		else if (option == "--threads" && i + 1 < argc)
+			maxThreads = std::max(1, atoi(argv[++i]));
+		else if (option == "--level" && i + 1 < argc)
+			onlyLevel = std::max(0, std::min(finalLevel, atoi(argv[++i])));
+		else if (option == "--agent" && i + 1 < argc)
+			useRandomAgent = std::string(argv[++i]) == "random";
+		else if (option == "--noise" && i + 1 < argc)
+			agentNoise = atof(argv[++i]);
+		else if (option == "--seed" && i + 1 < argc)
+			baseSeed = (unsigned int)atoi(argv[++i]);
+		else if (option == "--maze" && i + 1 < argc)
+			mazeFile = argv[++i];
+		else if (option == "--step-rate" && i + 1 < argc)
+			stepRate = std::max(1, atoi(argv[++i]));
+		else if (option == "--scaling")
+			measureScaling = true;
+	}
+	stepSeconds = 1.0f / stepRate;
+	maxSteps = 13000 * stepRate / 60;
+
+	// Levels are parsed once and copied into every run's state
+	GameState levels;
+	levels.verbose = false;
+	if (!loadLevels(levels, mazeFile))
+		return -1;
+
+	ThreadPool pool(maxThreads);
+	std::cout << "Batch: " << runCount << " runs, " << (useRandomAgent ? "random" : "seek") << " agent, "
+			  << pool.getThreadCount() << " threads, " << stepRate << " steps/s" << std::endl;
+
+	std::vector<RunResult> results;
+	double seconds = runBatch(pool, levels, results);
+	reportLevels(results);
+
+	std::cout << std::fixed << std::setprecision(1)
+			  << "\n" << runCount / seconds << " simulations/s (" << seconds * 1000.0 << " ms)" << std::endl;
+
+	if (measureScaling)
+		reportScaling(levels);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------// Agents //----------------------------------------------------------*/
+// Per-run random numbers, seeded from the run index so results do not depend on thread count
+int nextRandom(unsigned int &seed)
+{
+	seed = seed * 1103515245u + 12345u;
+	return (seed >> 16) & 0x7fff;
+}
+
+bool isWalkable(const GameState &state, int i, int j)
+{
+	return i >= 0 && j >= 0 && i < MAZE_HEIGHT && j < MAZE_WIDTH && state.MAZE[i][j] >= 1;
+}
+
+// First tile on the shortest walkable path to the nearest coin, false when no coin can be reached
+bool nextTileTowardsCoin(const GameState &state, int &nextI, int &nextJ)
+{
+	int startI = GridTraversal::tileOf(state.tankPosition.x);
+	int startJ = GridTraversal::tileOf(state.tankPosition.z);
+	if (!isWalkable(state, startI, startJ))
+		return false;
+
+	// Breadth-first search, remembering which tile each one was reached from
+	int from[MAZE_HEIGHT][MAZE_WIDTH];
+	for (int i = 0; i < MAZE_HEIGHT; i++)
+		for (int j = 0; j < MAZE_WIDTH; j++)
+			from[i][j] = -1;
+
+	int queue[MAZE_HEIGHT * MAZE_WIDTH];
+	int head = 0, tail = 0;
+	queue[tail++] = startI * MAZE_WIDTH + startJ;
+	from[startI][startJ] = queue[0];
+
+	const int di[4] = {1, -1, 0, 0};
+	const int dj[4] = {0, 0, 1, -1};
+	while (head < tail)
+	{
+		int tile = queue[head++];
+		int i = tile / MAZE_WIDTH;
+		int j = tile % MAZE_WIDTH;
+
+		if (state.MAZE[i][j] == 2 && tile != queue[0])
+		{
+			// Walk back to the tile after the start
+			while (from[i][j] != queue[0])
+			{
+				tile = from[i][j];
+				i = tile / MAZE_WIDTH;
+				j = tile % MAZE_WIDTH;
+			}
+			nextI = i;
+			nextJ = j;
+			return true;
+		}
+
+		for (int d = 0; d < 4; d++)
+		{
+			int ni = i + di[d];
+			int nj = j + dj[d];
+			if (isWalkable(state, ni, nj) && from[ni][nj] < 0)
+			{
+				from[ni][nj] = tile;
+				queue[tail++] = ni * MAZE_WIDTH + nj;
+			}
+		}
+	}
+	return false;
+}
+
+// Tile centre the seeking agent is driving to - it only moves on once the tank gets there,
+// so corners are turned on the tile rather than cut across the gap next to them
+struct Waypoint
+{
+	bool valid;
+	int i, j;
+};
+
+// Turn on the spot towards the waypoint, drive once lined up
+void seekAgent(const GameState &state, Waypoint &waypoint, Input &input)
+{
+	// New waypoint: the tile the tank is on first, then the next tile on the path to a coin
+	if (!waypoint.valid)
+	{
+		waypoint.i = GridTraversal::tileOf(state.tankPosition.x);
+		waypoint.j = GridTraversal::tileOf(state.tankPosition.z);
+		waypoint.valid = true;
+	}
+
+	// Tile (i, j) is centred at (2i, 2j); forward is (sin, cos) of the tank rotation
+	float dx = waypoint.i * 2.0f - state.tankPosition.x;
+	float dz = waypoint.j * 2.0f - state.tankPosition.z;
+	if (dx * dx + dz * dz < 0.2f * 0.2f)
+	{
+		if (!nextTileTowardsCoin(state, waypoint.i, waypoint.j))
+			return;
+		dx = waypoint.i * 2.0f - state.tankPosition.x;
+		dz = waypoint.j * 2.0f - state.tankPosition.z;
+	}
+	float heading = atan2(dx, dz) * (180.0f / M_PI);
+
+	float difference = fmod(heading - state.tankRotation, 360.0f);
+	if (difference > 180.0f)
+		difference -= 360.0f;
+	if (difference < -180.0f)
+		difference += 360.0f;
+
+	// Lined up within 2 degrees, or one step of turning (60 degrees a second) at coarse step rates so it cannot overshoot both ways
+	float tolerance = std::max(2.0f, 60.0f * stepSeconds);
+	if (difference > tolerance)
+		input.keys['a'] = true;
+	else if (difference < -tolerance)
+		input.keys['d'] = true;
+	else
+		input.keys['w'] = true;
+}
+
+// Hold a random combination of keys, firing now and then
+void randomAgent(unsigned int &seed, Input &input)
+{
+	const unsigned char moves[4] = {'w', 's', 'a', 'd'};
+	for (int m = 0; m < 4; m++)
+		input.keys[moves[m]] = nextRandom(seed) % 3 == 0;
+	input.keys[' '] = nextRandom(seed) % 20 == 0;
+
+	if (nextRandom(seed) % 4 == 0)
+		input.push(InputEvent::FIRE);
+}
+
+/*---------------------------------------------------------// Simulation //--------------------------------------------------------*/
+// Play one level from the start until it is completed, lost or the step limit is hit
+RunResult runSimulation(const GameState &levels, int run)
+{
+	RunResult result;
+	result.level = onlyLevel > 0 ? onlyLevel : 1 + run % finalLevel;
+	result.outcome = STEP_LIMIT;
+	result.coins = 0;
+
+	unsigned int seed = baseSeed * 2654435761u + (unsigned int)run;
+
+	GameState state = levels;
+	state.randomSeed = seed;
+	startLevel(state, result.level);
+	result.totalCoins = state.totalCoins;
+
+	Input input;
+	Waypoint waypoint = {false, 0, 0};
+	int holdSteps = 0; // Steps left on the current random action
+	int steps;
+	for (steps = 0; steps < maxSteps; steps++)
+	{
+		// Decisions are made every few steps, as a player would
+		if (holdSteps > 0)
+		{
+			holdSteps--;
+		}
+		else if (useRandomAgent || (float)nextRandom(seed) / 32768.0f < agentNoise)
+		{
+			randomAgent(seed, input);
+			holdSteps = 10 + nextRandom(seed) % 50;
+			waypoint.valid = false; // Re-plan from wherever the random action ends
+		}
+		else
+		{
+			input.keys['w'] = input.keys['s'] = input.keys['a'] = input.keys['d'] = input.keys[' '] = false;
+			seekAgent(state, waypoint, input);
+		}
+
+		step(state, input, stepSeconds);
+		input.events.clear();
+
+		for (size_t t = 0; t < state.events.tiles.size(); t++)
+		{
+			if (state.events.tiles[t].from == 2)
+				result.coins++;
+		}
+
+		if (state.levelComplete || state.gameWon)
+		{
+			result.outcome = COMPLETED;
+			break;
+		}
+		if (state.isGameOver)
+		{
+			result.outcome = state.isfalling ? FELL : TIMED_OUT;
+			break;
+		}
+	}
+
+	result.seconds = std::min(steps + 1, maxSteps) * stepSeconds;
+	return result;
+}
+
+// Every run as one task on the pool, returns wall clock seconds
+double runBatch(ThreadPool &pool, const GameState &levels, std::vector<RunResult> &results)
+{
+	results.assign(runCount, RunResult());
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	pool.parallelFor(runCount, [&](int run)
+					 { results[run] = runSimulation(levels, run); });
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*-----------------------------------------------------------// Reports //---------------------------------------------------------*/
+// Completion time, coins and deaths per level
+void reportLevels(const std::vector<RunResult> &results)
+{
+	std::cout << "\n"
+			  << std::left << std::setw(8) << "level" << std::right
+			  << std::setw(8) << "runs"
+			  << std::setw(11) << "complete"
+			  << std::setw(10) << "mean s"
+			  << std::setw(10) << "p50 s"
+			  << std::setw(10) << "p90 s"
+			  << std::setw(12) << "coins"
+			  << std::setw(8) << "falls"
+			  << std::setw(10) << "timeouts"
+			  << std::setw(8) << "stuck" << "\n";
+
+	for (int level = 1; level <= finalLevel; level++)
+	{
+		int runs = 0;
+		int counts[OUTCOME_COUNT] = {0, 0, 0, 0};
+		double coins = 0.0;
+		int totalCoins = 0;
+		std::vector<float> times;
+		for (size_t r = 0; r < results.size(); r++)
+		{
+			if (results[r].level != level)
+				continue;
+			runs++;
+			counts[results[r].outcome]++;
+			coins += results[r].coins;
+			totalCoins = results[r].totalCoins;
+			if (results[r].outcome == COMPLETED)
+				times.push_back(results[r].seconds);
+		}
+		if (runs == 0)
+			continue;
+
+		std::sort(times.begin(), times.end());
+		double mean = 0.0;
+		for (size_t t = 0; t < times.size(); t++)
+			mean += times[t];
+
+		std::ostringstream coinText;
+		coinText << std::fixed << std::setprecision(1) << coins / runs << "/" << totalCoins;
+
+		std::cout << std::left << std::setw(8) << level << std::right
+				  << std::setw(8) << runs
+				  << std::fixed << std::setprecision(1)
+				  << std::setw(10) << 100.0 * counts[COMPLETED] / runs << "%";
+		if (times.empty())
+			std::cout << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+		else
+			std::cout << std::setw(10) << mean / times.size()
+					  << std::setw(10) << times[times.size() / 2]
+					  << std::setw(10) << times[times.size() * 9 / 10];
+		std::cout << std::setw(12) << coinText.str()
+				  << std::setw(8) << counts[FELL]
+				  << std::setw(10) << counts[TIMED_OUT]
+				  << std::setw(8) << counts[STEP_LIMIT] << "\n";
+	}
+}
+
+// Same batch on 1, 2, 4 ... threads - results must not change, only the time
+void reportScaling(const GameState &levels)
+{
+	int hardwareThreads = maxThreads > 0 ? maxThreads : ThreadPool().getThreadCount();
+
+	std::vector<int> threadCounts;
+	for (int t = 1; t < hardwareThreads; t *= 2)
+		threadCounts.push_back(t);
+	threadCounts.push_back(hardwareThreads);
+
+	std::cout << "\nScaling (" << runCount << " runs)\n"
+			  << std::setw(8) << "threads"
+			  << std::setw(14) << "sims/s"
+			  << std::setw(10) << "speedup"
+			  << std::setw(12) << "efficiency" << "\n";
+
+	double baseline = 0.0;
+	uint64_t expected = 0;
+	bool identical = true;
+	for (size_t c = 0; c < threadCounts.size(); c++)
+	{
+		ThreadPool pool(threadCounts[c]);
+		std::vector<RunResult> results;
+		double rate = runCount / runBatch(pool, levels, results);
+
+		uint64_t hash = hashResults(results);
+		if (c == 0)
+		{
+			baseline = rate;
+			expected = hash;
+		}
+		identical = identical && hash == expected;
+
+		std::cout << std::setw(8) << threadCounts[c]
+				  << std::fixed << std::setprecision(1)
+				  << std::setw(14) << rate
+				  << std::setprecision(2)
+				  << std::setw(10) << rate / baseline
+				  << std::setw(11) << 100.0 * rate / baseline / threadCounts[c] << "%\n";
+	}
+	std::cout << (identical ? "Results identical on every thread count" : "Results differ between thread counts!") << std::endl;
+}
+
+// FNV-1a over every result field, to check thread count does not change the outcome
+uint64_t hashResults(const std::vector<RunResult> &results)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t r = 0; r < results.size(); r++)
+	{
+		int fields[4] = {results[r].level, (int)results[r].outcome, results[r].coins, (int)(results[r].seconds * 60.0f + 0.5f)};
+		const unsigned char *bytes = (const unsigned char *)fields;
+		for (size_t b = 0; b < sizeof(fields); b++)
+			hash = (hash ^ bytes[b]) * 1099511628211ULL;
+	}
+	return hash;
+}
+/*=================================================================================================================================*/
+/*--------------------------------------------------------------// END //----------------------------------------------------------*/
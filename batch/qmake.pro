@@ -0,0 +1,27 @@
+TEMPLATE = app
+
+#Executable Name
+TARGET = Batch
+CONFIG = release thread
+
+#Destination
+DESTDIR = .
+OBJECTS_DIR = ./build/
+
+HEADERS	+= 	../common/ThreadPool.h		    \
+		../simulation/GameState.h	    \
+        ../simulation/GridTraversal.h   \
+
+#Sources
+SOURCES += 	main.cpp			        \
+		../common/ThreadPool.cpp	    \
+
+INCLUDEPATH += 	./ 				    \
+		        ../common/ 			\
+		        ../simulation/ 		\
+
+#Library Libraries - the simulation library (build ../simulation first), no GL
+LIBS +=	-L../simulation -lSimulation    \
+        -lpthread                       \
+
+PRE_TARGETDEPS += ../simulation/libSimulation.a
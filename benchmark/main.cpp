@@ -0,0 +1,826 @@
+/*=================================================================================================================================*/
+/*-------------------------------------------------------// Start //---------------------------------------------------------------*/
+/*=================================================================================================================================*/
+// Offline benchmarks and reports - runs without a window or GL context
+// Usage: ./Benchmark [all|meshes|matrix|check|transforms|particles] - exits non-zero if a matrix check fails
+#include <Mesh.h>
+#include <Matrix.h>
+#include <Vector.h>
+#include <TransformBatch.h>
+#include <ThreadPool.h>
+#include <ParticlePool.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <dirent.h>
+#include <math.h>
+
+/*---------------------------------------------------// Function Prototypes //-----------------------------------------------------*/
+void reportMeshes(const std::string &modelDirectory);
+void reportMatrix();
+int checkMatrix();
+void reportAffine(Matrix4x4 &view);
+void reportRotation(Matrix4x4 &view);
+void reportTransforms();
+void reportParticles();
+
+// Main Program Entry
+int main(int argc, char **argv)
+{
+	std::string mode = (argc > 1) ? argv[1] : "all";
+	int failures = 0;
+
+	if (mode == "all" || mode == "meshes")
+		reportMeshes("../models/");
+	if (mode == "all" || mode == "matrix" || mode == "check")
+		failures += checkMatrix();
+	if (mode == "all" || mode == "matrix")
+		reportMatrix();
+	if (mode == "all" || mode == "transforms")
+		reportTransforms();
+	if (mode == "all" || mode == "particles")
+		reportParticles();
+
+	return failures > 0 ? 1 : 0;
+}
+
+/*---------------------------------------------------// Mesh Vertex Cache Report //------------------------------------------------*/
+void reportMeshes(const std::string &modelDirectory)
+{
+	// Collect every OBJ in the models directory
+	std::vector<std::string> files;
+	DIR *dir = opendir(modelDirectory.c_str());
+	if (!dir)
+	{
+		std::cerr << "Error: could not open model directory: " << modelDirectory << std::endl;
+		return;
+	}
+	for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+	{
+		std::string name = entry->d_name;
+		if (name.size() > 4 && name.substr(name.size() - 4) == ".obj")
+			files.push_back(name);
+	}
+	closedir(dir);
+	std::sort(files.begin(), files.end());
+
+	// Build each mesh on the CPU only and gather its statistics
+	std::vector<std::string> rows;
+	for (unsigned int i = 0; i < files.size(); i++)
+	{
+		Mesh mesh;
+		mesh.loadOBJ(modelDirectory + files[i], false);
+
+		std::ostringstream row;
+		row << std::left << std::setw(18) << files[i] << std::right
+			<< std::setw(10) << mesh.getTriangleCount()
+			<< std::setw(10) << mesh.getTriangleCount() * 3
+			<< std::setw(10) << mesh.getUniqueVertexCount()
+			<< std::fixed << std::setprecision(3)
+			<< std::setw(10) << 3.0f
+			<< std::setw(10) << mesh.getOriginalACMR()
+			<< std::setw(10) << mesh.getOptimisedACMR();
+		rows.push_back(row.str());
+	}
+
+	// ACMR = transformed vertices per triangle with a FIFO cache of Mesh::VERTEX_CACHE_SIZE entries
+	std::cout << "\nVertex cache report (FIFO " << Mesh::VERTEX_CACHE_SIZE << " entries)\n"
+			  << std::left << std::setw(18) << "model" << std::right
+			  << std::setw(10) << "tris"
+			  << std::setw(10) << "verts"
+			  << std::setw(10) << "unique"
+			  << std::setw(10) << "arrays"
+			  << std::setw(10) << "indexed"
+			  << std::setw(10) << "optimised" << "\n";
+	for (unsigned int i = 0; i < rows.size(); i++)
+		std::cout << rows[i] << "\n";
+	std::cout << std::endl;
+}
+/*---------------------------------------------------// Matrix Micro-Benchmark //-------------------------------------------------*/
+// The maze is 15 x 15 tiles, as in the game
+const int BENCH_TILES = 15 * 15;
+
+// Keeps results alive so the optimiser cannot drop the work being timed
+volatile float benchmarkSink;
+
+// Runs of every case at every level - interleaved, so a slow patch of machine time hits them all alike
+const int BENCH_RUNS = 15;
+
+// Time repeat calls of work, in nanoseconds per unit of work
+double timeNs(const std::function<void()> &work, int repeat, int units)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++)
+		work();
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	return ns / ((double)repeat * units);
+}
+
+// A camera looking at the maze from above, like the game's third person view
+Matrix4x4 benchmarkView()
+{
+	Matrix4x4 view;
+	view.lookAt(Vector3f(14.0f, 12.0f, 30.0f), Vector3f(14.0f, 0.0f, 14.0f), Vector3f(0.0f, 1.0f, 0.0f));
+	return view;
+}
+
+// Non-instanced DrawMaze: a translate per crate, and translate, scale, rotate for the coins and their shadows
+void drawMazePattern(Matrix4x4 &view, Matrix4x4 *out)
+{
+	for (int t = 0; t < BENCH_TILES; t++)
+	{
+		int i = t / 15, j = t % 15;
+		Matrix4x4 m = view;
+		m.translate(i * 2.0f, 0.0f, j * 2.0f);
+		out[t] = m;
+
+		// About one tile in eight carries a coin
+		if (t % 8 == 0)
+		{
+			Matrix4x4 coin = view;
+			coin.translate(i * 2.0f, 2.0f, j * 2.0f);
+			coin.scale(0.3f, 0.3f, 0.3f);
+			coin.rotate(45.0f, 0.0f, 1.0f, 0.0f);
+			out[t].set(coin);
+		}
+	}
+}
+
+// DrawTank: chassis, turret and two wheel transforms built from the camera
+void drawTankPattern(Matrix4x4 &view, Matrix4x4 *out)
+{
+	Matrix4x4 m = view;
+	m.translate(14.0f, 0.5f, 14.0f);
+	m.rotate(30.0f, 0.0f, 1.0f, 0.0f);
+	m.scale(0.3f, 0.3f, 0.3f);
+	m.translate(0.0f, 0.0f, 0.0f);
+	out[0] = m;
+
+	out[1] = m;
+	out[1].translate(0.0f, 0.0f, 0.0f);
+	out[1].rotate(15.0f, 0.0f, 1.0f, 0.0f);
+
+	out[2] = m;
+	out[2].translate(-0.1f, 1.0f, 2.2f);
+	out[2].rotate(10.0f, 0.0f, 1.0f, 0.0f);
+	out[2].rotate(120.0f, 1.0f, 0.0f, 0.0f);
+
+	out[3] = m;
+	out[3].translate(-0.1f, 1.1f, -1.3f);
+	out[3].rotate(-10.0f, 0.0f, 1.0f, 0.0f);
+	out[3].rotate(120.0f, 1.0f, 0.0f, 0.0f);
+}
+
+// DrawTank with axis rotations and the wheels' steer and roll composed as quaternions, as the game now draws it
+void drawTankAxisPattern(Matrix4x4 &view, Matrix4x4 *out)
+{
+	Matrix4x4 m = view;
+	m.translate(14.0f, 0.5f, 14.0f);
+	m.rotateY(30.0f);
+	m.scale(0.3f, 0.3f, 0.3f);
+	m.translate(0.0f, 0.0f, 0.0f);
+	out[0] = m;
+
+	out[1] = m;
+	out[1].translate(0.0f, 0.0f, 0.0f);
+	out[1].rotateY(15.0f);
+
+	Quaternion steer = Quaternion::rotationY(10.0f);
+	Quaternion roll = Quaternion::rotationX(120.0f);
+
+	out[2] = m;
+	out[2].translate(-0.1f, 1.0f, 2.2f);
+	out[2].rotate(steer * roll);
+
+	out[3] = m;
+	out[3].translate(-0.1f, 1.1f, -1.3f);
+	out[3].rotate(steer.conjugate() * roll);
+}
+
+// The translate, scale and rotate matrices the in-place operations used to build and multiply by
+Matrix4x4 translationMatrix(float x, float y, float z)
+{
+	return Matrix4x4(1, 0, 0, x, 0, 1, 0, y, 0, 0, 1, z, 0, 0, 0, 1);
+}
+
+Matrix4x4 scaleMatrix(float x, float y, float z)
+{
+	return Matrix4x4(x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0, 0, 0, 0, 1);
+}
+
+Matrix4x4 rotationMatrix(float angle, float x, float y, float z)
+{
+	Matrix4x4 rotation;
+	rotation.rotate(angle, x, y, z);
+	return rotation;
+}
+
+// DrawTank through full products, as before the affine fast paths - the rotations are built up front
+void drawTankGeneral(Matrix4x4 &view, Matrix4x4 *out, Matrix4x4 *rotations)
+{
+	Matrix4x4 m = view * translationMatrix(14.0f, 0.5f, 14.0f) * rotations[0] * scaleMatrix(0.3f, 0.3f, 0.3f) * translationMatrix(0.0f, 0.0f, 0.0f);
+	out[0] = m;
+	out[1] = m * translationMatrix(0.0f, 0.0f, 0.0f) * rotations[1];
+	out[2] = m * translationMatrix(-0.1f, 1.0f, 2.2f) * rotations[2] * rotations[4];
+	out[3] = m * translationMatrix(-0.1f, 1.1f, -1.3f) * rotations[3] * rotations[4];
+}
+
+// DrawTank with the same prebuilt rotations, but in-place translate and scale
+void drawTankAffine(Matrix4x4 &view, Matrix4x4 *out, Matrix4x4 *rotations)
+{
+	Matrix4x4 m = view;
+	m.translate(14.0f, 0.5f, 14.0f);
+	m *= rotations[0];
+	m.scale(0.3f, 0.3f, 0.3f);
+	m.translate(0.0f, 0.0f, 0.0f);
+	out[0] = m;
+
+	out[1] = m;
+	out[1].translate(0.0f, 0.0f, 0.0f);
+	out[1] *= rotations[1];
+
+	out[2] = m;
+	out[2].translate(-0.1f, 1.0f, 2.2f);
+	out[2] *= rotations[2];
+	out[2] *= rotations[4];
+
+	out[3] = m;
+	out[3].translate(-0.1f, 1.1f, -1.3f);
+	out[3] *= rotations[3];
+	out[3] *= rotations[4];
+}
+
+// Largest element difference between two sets of matrices
+float maxDifference(Matrix4x4 *a, Matrix4x4 *b, int count)
+{
+	float difference = 0.0f;
+	for (int m = 0; m < count; m++)
+		for (int e = 0; e < 16; e++)
+			difference = std::max(difference, fabsf(a[m].getPtr()[e] - b[m].getPtr()[e]));
+	return difference;
+}
+
+void reportMatrix()
+{
+	Matrix4x4 view = benchmarkView();
+
+	// Tile model matrices, as built for the instanced and baked maze paths
+	std::vector<Matrix4x4> models(BENCH_TILES);
+	for (int t = 0; t < BENCH_TILES; t++)
+		models[t].translate((t / 15) * 2.0f, 0.0f, (t % 15) * 2.0f);
+
+	std::vector<Vector3f> points(BENCH_TILES);
+	for (int t = 0; t < BENCH_TILES; t++)
+		points[t] = Vector3f(t * 0.1f, t * 0.2f, t * 0.3f);
+
+	const char *caseNames[] = {"multiply", "transformPoint", "multiplyBatch x225", "DrawMaze pattern", "DrawTank pattern"};
+	const int CASES = 5;
+	std::vector<Matrix4x4> results(BENCH_TILES);
+
+	// Each case with its repeat count and units of work per call
+	std::function<void()> cases[CASES] = {
+		[&]() {
+			for (int t = 0; t < BENCH_TILES; t++)
+				results[t] = view * models[t];
+		},
+		[&]() {
+			float sum = 0.0f;
+			for (int t = 0; t < BENCH_TILES; t++)
+				sum += view.transformPoint(points[t]).z;
+			benchmarkSink = sum;
+		},
+		[&]() { Matrix4x4::multiplyBatch(view, &models[0], &results[0], BENCH_TILES); },
+		[&]() { drawMazePattern(view, &results[0]); },
+		[&]() { drawTankPattern(view, &results[0]); },
+	};
+	const int repeats[CASES] = {200, 200, 200, 100, 5000};
+	const int units[CASES] = {BENCH_TILES, BENCH_TILES, BENCH_TILES, 1, 1};
+
+	Matrix4x4::SimdLevel supported = Matrix4x4::getSupportedSimdLevel();
+	double timing[3][CASES];
+	for (int level = 0; level < 3; level++)
+		for (int c = 0; c < CASES; c++)
+			timing[level][c] = 1e30;
+
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		for (int level = Matrix4x4::SIMD_SCALAR; level <= supported; level++)
+		{
+			Matrix4x4::setSimdLevel((Matrix4x4::SimdLevel)level);
+			for (int c = 0; c < CASES; c++)
+				timing[level][c] = std::min(timing[level][c], timeNs(cases[c], repeats[c], units[c]));
+		}
+	}
+
+	// Every level must give the scalar results exactly
+	float difference[3] = {0.0f, 0.0f, 0.0f};
+	std::vector<Matrix4x4> referenceBatch(BENCH_TILES), referenceMaze(BENCH_TILES);
+	for (int level = Matrix4x4::SIMD_SCALAR; level <= supported; level++)
+	{
+		Matrix4x4::setSimdLevel((Matrix4x4::SimdLevel)level);
+		std::vector<Matrix4x4> batch(BENCH_TILES), maze(BENCH_TILES);
+		Matrix4x4::multiplyBatch(view, &models[0], &batch[0], BENCH_TILES);
+		drawMazePattern(view, &maze[0]);
+		if (level == Matrix4x4::SIMD_SCALAR)
+		{
+			referenceBatch = batch;
+			referenceMaze = maze;
+		}
+		else
+		{
+			difference[level] = std::max(maxDifference(&referenceBatch[0], &batch[0], BENCH_TILES),
+										 maxDifference(&referenceMaze[0], &maze[0], BENCH_TILES));
+		}
+	}
+	Matrix4x4::setSimdLevel(supported);
+
+	// ns per matrix for the first three cases, per frame's worth of calls for the patterns
+	std::cout << "\nMatrix4x4 timings (best of " << BENCH_RUNS << ", ns: per call for the first three, per frame for the patterns)\n"
+			  << std::left << std::setw(22) << "case" << std::right;
+	for (int level = Matrix4x4::SIMD_SCALAR; level <= supported; level++)
+		std::cout << std::setw(10) << Matrix4x4::getSimdLevelName((Matrix4x4::SimdLevel)level);
+	for (int level = Matrix4x4::SIMD_SSE; level <= supported; level++)
+		std::cout << std::setw(10) << (std::string("x ") + Matrix4x4::getSimdLevelName((Matrix4x4::SimdLevel)level));
+	std::cout << "\n";
+
+	for (int c = 0; c < CASES; c++)
+	{
+		std::cout << std::left << std::setw(22) << caseNames[c] << std::right << std::fixed << std::setprecision(2);
+		for (int level = Matrix4x4::SIMD_SCALAR; level <= supported; level++)
+			std::cout << std::setw(10) << timing[level][c];
+		for (int level = Matrix4x4::SIMD_SSE; level <= supported; level++)
+			std::cout << std::setw(10) << timing[Matrix4x4::SIMD_SCALAR][c] / timing[level][c];
+		std::cout << "\n";
+	}
+
+	for (int level = Matrix4x4::SIMD_SSE; level <= supported; level++)
+		std::cout << "Largest difference from scalar (" << Matrix4x4::getSimdLevelName((Matrix4x4::SimdLevel)level)
+				  << "): " << std::scientific << difference[level] << std::fixed << "\n";
+	std::cout << std::endl;
+
+	reportAffine(view);
+}
+
+// In-place affine operations against the full products they replace, at the best SIMD level
+void reportAffine(Matrix4x4 &view)
+{
+	Matrix4x4 rotations[5] = {rotationMatrix(30.0f, 0.0f, 1.0f, 0.0f), rotationMatrix(15.0f, 0.0f, 1.0f, 0.0f),
+							  rotationMatrix(10.0f, 0.0f, 1.0f, 0.0f), rotationMatrix(-10.0f, 0.0f, 1.0f, 0.0f),
+							  rotationMatrix(120.0f, 1.0f, 0.0f, 0.0f)};
+	Matrix4x4 results[4], expected[4];
+	Matrix4x4 camera = view.affineInverse();
+
+	const char *caseNames[] = {"translate", "scale", "rotate", "inverse", "DrawTank chain"};
+	const int CASES = 5;
+	std::function<void()> general[CASES] = {
+		[&]() { results[0] = results[0] * translationMatrix(0.01f, 0.02f, 0.03f); },
+		[&]() { results[0] = results[0] * scaleMatrix(1.0f, 1.0f, 1.0f); },
+		[&]() { results[0] = results[0] * rotationMatrix(1.0f, 0.0f, 1.0f, 0.0f); },
+		[&]() { results[1] = camera.inverse(); },
+		[&]() { drawTankGeneral(view, results, rotations); },
+	};
+	std::function<void()> affine[CASES] = {
+		[&]() { results[0].translate(0.01f, 0.02f, 0.03f); },
+		[&]() { results[0].scale(1.0f, 1.0f, 1.0f); },
+		[&]() { results[0].rotate(1.0f, 0.0f, 1.0f, 0.0f); },
+		[&]() { results[1] = camera.affineInverse(); },
+		[&]() { drawTankAffine(view, results, rotations); },
+	};
+
+	double generalNs[CASES], affineNs[CASES];
+	for (int c = 0; c < CASES; c++)
+		generalNs[c] = affineNs[c] = 1e30;
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		for (int c = 0; c < CASES; c++)
+		{
+			results[0] = view;
+			generalNs[c] = std::min(generalNs[c], timeNs(general[c], 20000, 1));
+			results[0] = view;
+			affineNs[c] = std::min(affineNs[c], timeNs(affine[c], 20000, 1));
+		}
+	}
+
+	std::cout << "Affine fast paths (" << Matrix4x4::getSimdLevelName(Matrix4x4::getSimdLevel()) << ", best of " << BENCH_RUNS << ", ns per call)\n"
+			  << std::left << std::setw(22) << "case" << std::right
+			  << std::setw(10) << "general" << std::setw(10) << "affine" << std::setw(10) << "speedup" << "\n";
+	for (int c = 0; c < CASES; c++)
+	{
+		std::cout << std::left << std::setw(22) << caseNames[c] << std::right << std::fixed << std::setprecision(2)
+				  << std::setw(10) << generalNs[c] << std::setw(10) << affineNs[c] << std::setw(10) << generalNs[c] / affineNs[c] << "\n";
+	}
+
+	// The chain must match exactly; the two inverses use different formulas so only agree closely
+	drawTankGeneral(view, expected, rotations);
+	drawTankAffine(view, results, rotations);
+	std::cout << "Largest difference, DrawTank chain: " << std::scientific << maxDifference(expected, results, 4);
+	Matrix4x4 generalInverse = camera.inverse(), affineInverse = camera.affineInverse();
+	std::cout << "  inverse: " << maxDifference(&generalInverse, &affineInverse, 1) << std::fixed << "\n" << std::endl;
+
+	reportRotation(view);
+}
+
+// General axis-angle rotate() against the axis-specialised and quaternion forms, at the best SIMD level
+void reportRotation(Matrix4x4 &view)
+{
+	Matrix4x4 results[4], expected[4];
+	Quaternion spin = Quaternion::rotationY(1.0f);
+
+	const char *caseNames[] = {"rotateX", "rotateY", "quaternion coin spin", "DrawTank axis + quat"};
+	const int CASES = 4;
+	std::function<void()> general[CASES] = {
+		[&]() { results[0].rotate(1.0f, 1.0f, 0.0f, 0.0f); },
+		[&]() { results[0].rotate(1.0f, 0.0f, 1.0f, 0.0f); },
+		[&]() { results[0].rotate(1.0f, 0.0f, 1.0f, 0.0f); },
+		[&]() { drawTankPattern(view, results); },
+	};
+	std::function<void()> specialised[CASES] = {
+		[&]() { results[0].rotateX(1.0f); },
+		[&]() { results[0].rotateY(1.0f); },
+		[&]() { results[0].rotate(spin); },
+		[&]() { drawTankAxisPattern(view, results); },
+	};
+
+	double generalNs[CASES], specialisedNs[CASES];
+	for (int c = 0; c < CASES; c++)
+		generalNs[c] = specialisedNs[c] = 1e30;
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		for (int c = 0; c < CASES; c++)
+		{
+			results[0] = view;
+			generalNs[c] = std::min(generalNs[c], timeNs(general[c], 20000, 1));
+			results[0] = view;
+			specialisedNs[c] = std::min(specialisedNs[c], timeNs(specialised[c], 20000, 1));
+		}
+	}
+
+	std::cout << "Rotations (" << Matrix4x4::getSimdLevelName(Matrix4x4::getSimdLevel()) << ", best of " << BENCH_RUNS << ", ns per call)\n"
+			  << std::left << std::setw(22) << "case" << std::right
+			  << std::setw(10) << "rotate()" << std::setw(10) << "new" << std::setw(10) << "speedup" << "\n";
+	for (int c = 0; c < CASES; c++)
+	{
+		std::cout << std::left << std::setw(22) << caseNames[c] << std::right << std::fixed << std::setprecision(2)
+				  << std::setw(10) << generalNs[c] << std::setw(10) << specialisedNs[c] << std::setw(10) << generalNs[c] / specialisedNs[c] << "\n";
+	}
+
+	// The forms round differently, so they only agree to a few ulps
+	drawTankPattern(view, expected);
+	drawTankAxisPattern(view, results);
+	float tankDifference = maxDifference(expected, results, 4);
+	float axisDifference = 0.0f;
+	for (float angle = -180.0f; angle <= 180.0f; angle += 7.5f)
+	{
+		Matrix4x4 a[3] = {view, view, view}, b[3] = {view, view, view};
+		a[0].rotate(angle, 1.0f, 0.0f, 0.0f);
+		a[1].rotate(angle, 0.0f, 1.0f, 0.0f);
+		a[2].rotate(angle, 0.0f, 0.0f, 1.0f);
+		b[0].rotateX(angle);
+		b[1].rotateY(angle);
+		b[2].rotate(Quaternion::rotationZ(angle));
+		axisDifference = std::max(axisDifference, maxDifference(a, b, 3));
+	}
+	std::cout << "Largest difference from rotate(), DrawTank: " << std::scientific << tankDifference
+			  << "  single rotations: " << axisDifference << std::fixed << "\n" << std::endl;
+}
+/*---------------------------------------------------// Matrix Checks //--------------------------------------------------------*/
+// True if every element is equal - the in-place operations must give the full products bit for bit
+bool sameMatrix(Matrix4x4 &a, Matrix4x4 &b)
+{
+	for (int e = 0; e < 16; e++)
+		if (a.getPtr()[e] != b.getPtr()[e])
+			return false;
+	return true;
+}
+
+// True if every element is within tolerance of expected, relative to its size once that passes 1
+bool closeMatrix(Matrix4x4 &expected, Matrix4x4 &result, float tolerance)
+{
+	for (int e = 0; e < 16; e++)
+	{
+		float size = std::max(1.0f, fabsf(expected.getPtr()[e]));
+		if (!(fabsf(expected.getPtr()[e] - result.getPtr()[e]) <= tolerance * size))
+			return false;
+	}
+	return true;
+}
+
+// In-place translate, scale and rotate against the full products they replaced, and affineInverse() against
+// inverse(), at every SIMD level; prints each failure and returns how many there were
+int checkMatrix()
+{
+	Matrix4x4 view = benchmarkView();
+	Matrix4x4 tank[4];
+	drawTankPattern(view, tank);
+
+	// Affine matrices from the game: the camera, its inverse and the tank's chassis, turret and wheels
+	std::vector<Matrix4x4> affine;
+	affine.push_back(view);
+	affine.push_back(view.affineInverse());
+	for (int m = 0; m < 4; m++)
+		affine.push_back(tank[m]);
+
+	// The operations also apply to a projection, where the bottom row is not (0, 0, 0, 1)
+	std::vector<Matrix4x4> starts = affine;
+	Matrix4x4 projection;
+	projection.perspective(60.0f, 4.0f / 3.0f, 0.1f, 100.0f);
+	starts.push_back(projection * view);
+
+	const float steps[][3] = {{0.0f, 0.0f, 0.0f}, {14.0f, 0.5f, 14.0f}, {-0.1f, 1.1f, -1.3f}, {0.3f, 0.3f, 0.3f}, {-2.5f, 1e-3f, 7.0f}};
+	const float axes[][3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 2.0f, -3.0f}, {0.0f, -4.0f, 0.5f}};
+	const float angles[] = {-120.0f, -10.0f, 0.0f, 15.0f, 45.0f, 90.0f, 179.0f};
+	const float INVERSE_TOLERANCE = 1e-4f;
+
+	Matrix4x4::SimdLevel supported = Matrix4x4::getSupportedSimdLevel();
+	int failures = 0, checks = 0;
+	for (int level = Matrix4x4::SIMD_SCALAR; level <= supported; level++)
+	{
+		Matrix4x4::setSimdLevel((Matrix4x4::SimdLevel)level);
+		const char *levelName = Matrix4x4::getSimdLevelName((Matrix4x4::SimdLevel)level);
+
+		for (size_t m = 0; m < starts.size(); m++)
+		{
+			for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++)
+			{
+				const float *v = steps[s];
+				Matrix4x4 translated = starts[m], scaled = starts[m];
+				translated.translate(v[0], v[1], v[2]);
+				scaled.scale(v[0], v[1], v[2]);
+				Matrix4x4 expectedTranslate = starts[m] * translationMatrix(v[0], v[1], v[2]);
+				Matrix4x4 expectedScale = starts[m] * scaleMatrix(v[0], v[1], v[2]);
+
+				checks += 2;
+				if (!sameMatrix(expectedTranslate, translated))
+				{
+					std::cout << "FAIL (" << levelName << "): translate, matrix " << m << ", step " << s << "\n";
+					failures++;
+				}
+				if (!sameMatrix(expectedScale, scaled))
+				{
+					std::cout << "FAIL (" << levelName << "): scale, matrix " << m << ", step " << s << "\n";
+					failures++;
+				}
+			}
+
+			for (size_t a = 0; a < sizeof(axes) / sizeof(axes[0]); a++)
+			{
+				for (size_t g = 0; g < sizeof(angles) / sizeof(angles[0]); g++)
+				{
+					const float *axis = axes[a];
+					Matrix4x4 rotated = starts[m];
+					rotated.rotate(angles[g], axis[0], axis[1], axis[2]);
+					Matrix4x4 expected = starts[m] * rotationMatrix(angles[g], axis[0], axis[1], axis[2]);
+
+					checks++;
+					if (!sameMatrix(expected, rotated))
+					{
+						std::cout << "FAIL (" << levelName << "): rotate, matrix " << m << ", axis " << a << ", angle " << angles[g] << "\n";
+						failures++;
+					}
+				}
+			}
+		}
+
+		// The DrawTank chain as the game builds it
+		Matrix4x4 rotations[5] = {rotationMatrix(30.0f, 0.0f, 1.0f, 0.0f), rotationMatrix(15.0f, 0.0f, 1.0f, 0.0f),
+								  rotationMatrix(10.0f, 0.0f, 1.0f, 0.0f), rotationMatrix(-10.0f, 0.0f, 1.0f, 0.0f),
+								  rotationMatrix(120.0f, 1.0f, 0.0f, 0.0f)};
+		Matrix4x4 expectedChain[4], chain[4];
+		drawTankGeneral(view, expectedChain, rotations);
+		drawTankAffine(view, chain, rotations);
+		for (int m = 0; m < 4; m++)
+		{
+			checks++;
+			if (!sameMatrix(expectedChain[m], chain[m]))
+			{
+				std::cout << "FAIL (" << levelName << "): DrawTank chain, matrix " << m << "\n";
+				failures++;
+			}
+		}
+
+		// The two inverses use different formulas, so they only agree closely
+		for (size_t m = 0; m < affine.size(); m++)
+		{
+			Matrix4x4 expected = affine[m].inverse(), result = affine[m].affineInverse();
+			checks++;
+			if (!closeMatrix(expected, result, INVERSE_TOLERANCE))
+			{
+				std::cout << "FAIL (" << levelName << "): affineInverse, matrix " << m << ", largest difference "
+						  << std::scientific << maxDifference(&expected, &result, 1) << std::fixed << "\n";
+				failures++;
+			}
+		}
+	}
+	Matrix4x4::setSimdLevel(supported);
+
+	std::cout << "\nMatrix4x4 checks: " << checks - failures << " of " << checks << " passed" << std::endl;
+	return failures;
+}
+
+/*---------------------------------------------------// Transform Stage Benchmark //----------------------------------------------*/
+// Maze matrices for a side x side grid built one object at a time, as DrawMaze did: a crate per tile, and a spinning
+// coin and shadow on one tile in eight. Model matrices for the instanced path, or premultiplied by view for the per-tile one
+void mazeTransformsPerObject(int side, const Matrix4x4 *view, std::vector<Matrix4x4> &out)
+{
+	Quaternion spin = Quaternion::rotationY(45.0f);
+	Matrix4x4 start;
+	if (view)
+		start = *view;
+
+	out.clear();
+	for (int t = 0; t < side * side; t++)
+	{
+		int i = t / side, j = t % side;
+		Matrix4x4 crate = start;
+		crate.translate(i * 2.0f, 0.0f, j * 2.0f);
+		out.push_back(crate);
+		if (t % 8 == 0)
+		{
+			Matrix4x4 shadow = start;
+			shadow.translate(i * 2.0f, 1.4f, j * 2.0f);
+			shadow.scale(0.3f, 0.01f, 0.3f);
+			shadow.rotate(spin);
+			out.push_back(shadow);
+
+			Matrix4x4 coin = start;
+			coin.translate(i * 2.0f, 2.0f, j * 2.0f);
+			coin.scale(0.3f, 0.3f, 0.3f);
+			coin.rotate(spin);
+			out.push_back(coin);
+		}
+	}
+}
+
+// The same matrices through the transform stage, in the same order
+void mazeTransformsBatched(int side, const Matrix4x4 *view, TransformBatch &batch, std::vector<Matrix4x4> &out, ThreadPool *pool)
+{
+	batch.clear();
+	for (int t = 0; t < side * side; t++)
+	{
+		int i = t / side, j = t % side;
+		batch.add(i * 2.0f, 0.0f, j * 2.0f);
+		if (t % 8 == 0)
+		{
+			batch.add(i * 2.0f, 1.4f, j * 2.0f, 45.0f, 0.3f, 0.01f, 0.3f);
+			batch.add(i * 2.0f, 2.0f, j * 2.0f, 45.0f, 0.3f, 0.3f, 0.3f);
+		}
+	}
+	out.resize(batch.size());
+	batch.compute(&out[0], view, pool);
+}
+
+void reportTransforms()
+{
+	Matrix4x4 view = benchmarkView();
+	ThreadPool pool;
+	const int sides[] = {15, 100, 320};
+	const int SIZES = 3;
+
+	std::cout << "\nMaze transform stage (" << Matrix4x4::getSimdLevelName(Matrix4x4::getSimdLevel()) << ", best of " << BENCH_RUNS
+			  << ", ns per matrix including the gather, pool of " << pool.getThreadCount() << " threads)\n"
+			  << std::left << std::setw(22) << "tiles" << std::right
+			  << std::setw(12) << "per object" << std::setw(10) << "batched" << std::setw(10) << "pooled"
+			  << std::setw(10) << "speedup" << std::setw(12) << "difference" << "\n";
+
+	for (int size = 0; size < SIZES; size++)
+	{
+		for (int viewSpace = 0; viewSpace < 2; viewSpace++)
+		{
+			int side = sides[size];
+			const Matrix4x4 *premultiply = viewSpace ? &view : NULL;
+			std::vector<Matrix4x4> expected, results;
+			TransformBatch batch;
+			mazeTransformsPerObject(side, premultiply, expected);
+			int matrices = (int)expected.size();
+			int repeat = std::max(1, 2000000 / matrices);
+
+			double perObjectNs = 1e30, batchedNs = 1e30, pooledNs = 1e30;
+			for (int run = 0; run < BENCH_RUNS; run++)
+			{
+				perObjectNs = std::min(perObjectNs, timeNs([&]() { mazeTransformsPerObject(side, premultiply, results); }, repeat, matrices));
+				batchedNs = std::min(batchedNs, timeNs([&]() { mazeTransformsBatched(side, premultiply, batch, results, NULL); }, repeat, matrices));
+				pooledNs = std::min(pooledNs, timeNs([&]() { mazeTransformsBatched(side, premultiply, batch, results, &pool); }, repeat, matrices));
+			}
+
+			// The stage takes the sin/cos of the whole angle rather than through a quaternion, so it differs by rounding
+			mazeTransformsBatched(side, premultiply, batch, results, &pool);
+			std::ostringstream name;
+			name << side * side << (viewSpace ? " per tile" : " instanced");
+			std::cout << std::left << std::setw(22) << name.str() << std::right << std::fixed << std::setprecision(2)
+					  << std::setw(12) << perObjectNs << std::setw(10) << batchedNs << std::setw(10) << pooledNs
+					  << std::setw(10) << perObjectNs / std::min(batchedNs, pooledNs)
+					  << std::setw(12) << std::scientific << maxDifference(&expected[0], &results[0], matrices)
+					  << std::fixed << "\n";
+		}
+	}
+	std::cout << std::endl;
+}
+/*---------------------------------------------------// Particle Update Benchmark //----------------------------------------------*/
+// A coin pickup particle as the game kept them, one struct per particle in a std::vector
+struct BenchParticle
+{
+	Vector3f position;
+	Vector3f velocity;
+	float life;
+};
+
+// Stand-ins for the old Vector.cpp operators, which took their arguments by value and could not be inlined
+#ifdef __GNUC__
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE Vector3f addOutOfLine(Vector3f lhs, Vector3f rhs)
+{
+	return Vector3f(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z);
+}
+
+BENCH_NOINLINE Vector3f scaleOutOfLine(Vector3f lhs, float rhs)
+{
+	return Vector3f(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs);
+}
+
+// updateParticles' two passes: move and age every particle, then look for one still alive
+template <typename Move>
+void updateParticleVector(std::vector<BenchParticle> &particles, float dt, Move move)
+{
+	for (auto &p : particles)
+	{
+		p.life -= dt;
+		move(p, dt);
+	}
+
+	bool anyAlive = false;
+	for (const auto &p : particles)
+	{
+		if (p.life > 0.0f)
+		{
+			anyAlive = true;
+			break;
+		}
+	}
+	benchmarkSink = anyAlive ? particles[0].position.x : 0.0f;
+}
+
+// updateParticles with out-of-line Vector3f, with the inline header, and ParticlePool::update, the particles long-lived
+// so every step is a full pass and none are removed
+void reportParticles()
+{
+	static ParticlePool pool;
+	const int counts[] = {100, 1000};
+	const int SIZES = 2;
+	const float dt = 1.0f / 60.0f;
+
+	std::cout << "\nParticle update (best of " << BENCH_RUNS << ", ns per particle per step)\n"
+			  << std::left << std::setw(22) << "particles" << std::right
+			  << std::setw(12) << "out-of-line" << std::setw(10) << "inline" << std::setw(10) << "pool"
+			  << std::setw(10) << "speedup" << "\n";
+
+	for (int size = 0; size < SIZES; size++)
+	{
+		int count = counts[size];
+		std::vector<BenchParticle> particles(count);
+		pool.clear();
+		pool.emit(count);
+		for (int p = 0; p < count; p++)
+		{
+			Vector3f velocity((p % 7) - 3.0f, 2.0f + (p % 5), (p % 11) - 5.0f);
+			particles[p].position = Vector3f(14.0f, 2.0f, 14.0f);
+			particles[p].velocity = velocity;
+			particles[p].life = 1e6f;
+			pool.positionX[p] = 14.0f;
+			pool.positionY[p] = 2.0f;
+			pool.positionZ[p] = 14.0f;
+			pool.velocityX[p] = velocity.x;
+			pool.velocityY[p] = velocity.y;
+			pool.velocityZ[p] = velocity.z;
+			pool.life[p] = 1e6f;
+		}
+
+		int repeat = 2000000 / count;
+		double outOfLineNs = 1e30, inlineNs = 1e30, poolNs = 1e30;
+		for (int run = 0; run < BENCH_RUNS; run++)
+		{
+			outOfLineNs = std::min(outOfLineNs, timeNs([&]() {
+				updateParticleVector(particles, dt, [](BenchParticle &p, float step) { p.position = addOutOfLine(p.position, scaleOutOfLine(p.velocity, step)); });
+			}, repeat, count));
+			inlineNs = std::min(inlineNs, timeNs([&]() {
+				updateParticleVector(particles, dt, [](BenchParticle &p, float step) { p.position += p.velocity * step; });
+			}, repeat, count));
+			poolNs = std::min(poolNs, timeNs([&]() { pool.update(dt); }, repeat, count));
+		}
+
+		std::cout << std::left << std::setw(22) << count << std::right << std::fixed << std::setprecision(2)
+				  << std::setw(12) << outOfLineNs << std::setw(10) << inlineNs << std::setw(10) << poolNs
+				  << std::setw(10) << outOfLineNs / poolNs << "\n";
+	}
+	std::cout << std::endl;
+}
+/*=================================================================================================================================*/
+/*--------------------------------------------------------------// END //----------------------------------------------------------*/
@@ -0,0 +1,40 @@
+
+TEMPLATE = app
+
+#Executable Name
+TARGET = Benchmark
+CONFIG = release thread
+
+#Destination
+DESTDIR = .
+OBJECTS_DIR = ./build/
+
+HEADERS	+= 	../common/Vector.h		        \
+		../common/Matrix.h		        \
+		../common/Mesh.h		        \
+        ../common/VertexAttributes.h    \
+        ../common/InstanceBuffer.h      \
+        ../common/TransformBatch.h      \
+        ../common/ThreadPool.h          \
+        ../common/Profiler.h            \
+        ../simulation/ParticlePool.h    \
+
+#Sources
+SOURCES += 	main.cpp			        \
+		../common/Matrix.cpp		    \
+		../common/Mesh.cpp		        \
+        ../common/InstanceBuffer.cpp    \
+        ../common/TransformBatch.cpp    \
+        ../common/ThreadPool.cpp        \
+        ../common/Profiler.cpp          \
+        ../simulation/ParticlePool.cpp  \
+
+INCLUDEPATH += 	./ 				    \
+		        ../common/ 			\
+		        ../simulation/ 		\
+
+#Library Libraries - GL is linked but no context is created
+LIBS +=	-lGLEW			    	    	        \
+        -lGL                            \
+        -lpthread                       \
+
@@ -0,0 +1,170 @@
+#include "AudioBackend.h"
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*-------------------------------------------------------// Null //----------------------------------------------------------------*/
+
+//! Nothing to open
+bool NullAudioBackend::open(int sampleRate)
+{
+	this->sampleRate = sampleRate;
+	started = false;
+	return true;
+}
+
+//! Throw the block away in real time
+bool NullAudioBackend::write(const int16_t *, int frameCount)
+{
+	pace(frameCount);
+	return true;
+}
+
+//! Blocks are due back to back, resynchronising after a stall rather than rushing to catch up
+void NullAudioBackend::pace(int frameCount)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if(!started || nextBlock < now)
+	{
+		nextBlock = now;
+		started = true;
+	}
+
+	nextBlock += std::chrono::microseconds((int64_t)frameCount * 1000000 / sampleRate);
+	std::this_thread::sleep_until(nextBlock);
+}
+
+/*-------------------------------------------------------// WAV File //------------------------------------------------------------*/
+
+//! Little-endian field writers for the header
+static void writeU32(std::ofstream & file, uint32_t value)
+{
+	file.write((const char *)&value, 4);
+}
+
+static void writeU16(std::ofstream & file, uint16_t value)
+{
+	file.write((const char *)&value, 2);
+}
+
+//! Header with empty sizes, filled in by close()
+bool WavFileAudioBackend::open(int sampleRate)
+{
+	NullAudioBackend::open(sampleRate);
+
+	file.open(filename.c_str(), std::ios::binary);
+	if(!file)
+	{
+		std::cout << "Could not open audio output " << filename << std::endl;
+		return false;
+	}
+
+	file.write("RIFF", 4);
+	writeU32(file, 0);
+	file.write("WAVEfmt ", 8);
+	writeU32(file, 16);
+	writeU16(file, 1);					// PCM
+	writeU16(file, 2);					// Stereo
+	writeU32(file, sampleRate);
+	writeU32(file, sampleRate * 4);		// Bytes per second
+	writeU16(file, 4);					// Bytes per frame
+	writeU16(file, 16);					// Bits per sample
+	file.write("data", 4);
+	writeU32(file, 0);
+
+	dataBytes = 0;
+	return true;
+}
+
+//! Append the block, paced like the null backend
+bool WavFileAudioBackend::write(const int16_t * frames, int frameCount)
+{
+	file.write((const char *)frames, frameCount * 4);
+	dataBytes += frameCount * 4;
+	pace(frameCount);
+	return (bool)file;
+}
+
+//! Patch the RIFF and data sizes now the length is known
+void WavFileAudioBackend::close()
+{
+	if(!file.is_open())
+		return;
+
+	file.seekp(4);
+	writeU32(file, 36 + dataBytes);
+	file.seekp(40);
+	writeU32(file, dataBytes);
+	file.close();
+}
+
+/*-------------------------------------------------------// Player Pipe //---------------------------------------------------------*/
+
+//! Start the first player found on the PATH
+bool PipeAudioBackend::open(int sampleRate)
+{
+	// A player that exits must fail write(), not kill the game
+	signal(SIGPIPE, SIG_IGN);
+
+	std::string rate = std::to_string(sampleRate);
+	const std::string players[] = {
+		"aplay -q -t raw -f S16_LE -c 2 --buffer-time=50000 -r " + rate,
+		"paplay --raw --format=s16le --channels=2 --latency-msec=50 --rate=" + rate,
+	};
+
+	for(int p = 0; p < 2; p++)
+	{
+		std::string program = players[p].substr(0, players[p].find(' '));
+		if(system(("command -v " + program + " > /dev/null 2>&1").c_str()) != 0)
+			continue;
+
+		pipe = popen((players[p] + " 2> /dev/null").c_str(), "w");
+		if(!pipe)
+			continue;
+
+		// The default 64 KB pipe would queue over a third of a second of sound
+		fcntl(fileno(pipe), F_SETPIPE_SZ, 4096);
+		return true;
+	}
+
+	std::cout << "No audio player found (aplay or paplay)" << std::endl;
+	return false;
+}
+
+//! Unbuffered so each block leaves as soon as it is mixed
+bool PipeAudioBackend::write(const int16_t * frames, int frameCount)
+{
+	const char * bytes = (const char *)frames;
+	size_t remaining = frameCount * 4;
+	while(remaining > 0)
+	{
+		ssize_t written = ::write(fileno(pipe), bytes, remaining);
+		if(written <= 0)
+			return false;
+		bytes += written;
+		remaining -= written;
+	}
+	return true;
+}
+
+//! Let the player finish what it has and exit
+void PipeAudioBackend::close()
+{
+	if(pipe)
+		pclose(pipe);
+	pipe = 0;
+}
+
+/*-------------------------------------------------------// Factory //-------------------------------------------------------------*/
+
+AudioBackend * createAudioBackend(const std::string & name)
+{
+	if(name == "device")
+		return new PipeAudioBackend();
+	if(name == "null")
+		return new NullAudioBackend();
+	return new WavFileAudioBackend(name);
+}
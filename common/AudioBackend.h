@@ -0,0 +1,114 @@
+#ifndef AUDIOBACKEND_H_
+#define AUDIOBACKEND_H_
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Where the mixed audio goes. The audio thread calls write() with one block
+ * of interleaved 16-bit stereo frames at a time; write() returns once the
+ * block has been taken, which is what paces the mixer to real time.
+ */
+class AudioBackend
+{
+
+public:
+
+	//! Destructor
+	virtual ~AudioBackend(){};
+
+	//! Prepare for frames at sampleRate, false if the output is unavailable
+	virtual bool open(int sampleRate) = 0;
+
+	//! Consume frameCount stereo frames, false once the output has failed
+	virtual bool write(const int16_t * frames, int frameCount) = 0;
+
+	//! Flush and release the output
+	virtual void close() = 0;
+
+	//! Name for messages
+	virtual const char * getName() = 0;
+
+};
+
+/**
+ * Discards everything, sleeping for the length of each block so the mixer
+ * runs as it would with a sound card. For machines without sound hardware.
+ */
+class NullAudioBackend : public AudioBackend
+{
+
+public:
+
+	bool open(int sampleRate);
+	bool write(const int16_t * frames, int frameCount);
+	void close(){};
+	const char * getName(){ return "null"; };
+
+protected:
+
+	//! Sleep until the block of frameCount frames would have finished playing
+	void pace(int frameCount);
+
+	int sampleRate;
+	std::chrono::steady_clock::time_point nextBlock;
+	bool started;
+
+};
+
+/**
+ * Records the mix to a 16-bit stereo WAV file in real time, so what the
+ * game played can be listened to or compared afterwards.
+ */
+class WavFileAudioBackend : public NullAudioBackend
+{
+
+public:
+
+	//! Constructor - the file is created by open()
+	WavFileAudioBackend(const std::string & filename) : filename(filename), dataBytes(0){};
+
+	bool open(int sampleRate);
+	bool write(const int16_t * frames, int frameCount);
+	void close();
+	const char * getName(){ return "file"; };
+
+private:
+
+	std::string filename;
+	std::ofstream file;
+	uint32_t dataBytes;
+
+};
+
+/**
+ * Streams raw PCM into one long-running system player (aplay, or paplay
+ * on PulseAudio/PipeWire) through a pipe kept to a page so latency stays
+ * low. The player is started once, not per sound.
+ */
+class PipeAudioBackend : public AudioBackend
+{
+
+public:
+
+	//! Constructor
+	PipeAudioBackend() : pipe(0){};
+
+	bool open(int sampleRate);
+	bool write(const int16_t * frames, int frameCount);
+	void close();
+	const char * getName(){ return "device"; };
+
+private:
+
+	FILE * pipe;
+
+};
+
+//! Backend for a --audio argument: "device", "null" or the name of a .wav file to record to
+AudioBackend * createAudioBackend(const std::string & name);
+
+#endif
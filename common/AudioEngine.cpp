@@ -0,0 +1,450 @@
+#include "AudioEngine.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+const size_t AudioEngine::DEFAULT_STREAM_THRESHOLD;
+const size_t AudioEngine::STREAM_CHUNK_BYTES;
+
+//! Constructor
+AudioEngine::AudioEngine()
+	: streamThreshold(DEFAULT_STREAM_THRESHOLD), backend(0), sampleRate(44100), running(false), droppedCommands(0), voiceOrder(0), activeVoices(0)
+{
+	for(int v = 0; v < MAX_VOICES; v++)
+	{
+		voices[v].active = false;
+	}
+}
+
+//! Destructor - unmap streamed clips once nothing can be playing them
+AudioEngine::~AudioEngine()
+{
+	stop();
+
+	for(size_t c = 0; c < clips.size(); c++)
+	{
+		if(clips[c].mapping)
+			munmap(clips[c].mapping, clips[c].mappingSize);
+	}
+}
+
+/*-------------------------------------------------------// Loading //-------------------------------------------------------------*/
+
+//! Walk the RIFF chunks for the format and the samples, skipping LIST and anything else
+int AudioEngine::load(const std::string & filename)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	char riff[12];
+	if(!file.read(riff, 12) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+	{
+		std::cout << "Not a WAV file: " << filename << std::endl;
+		return -1;
+	}
+
+	Clip clip;
+	clip.name = filename;
+	clip.sampleRate = 0;
+	clip.channels = 0;
+	clip.frames = 0;
+
+	clip.mapping = 0;
+	clip.mappingSize = 0;
+	clip.dataOffset = 0;
+
+	int bitsPerSample = 0;
+	int format = 0;
+	size_t dataBytes = 0;
+	char chunkId[4];
+	uint32_t chunkSize;
+	while(file.read(chunkId, 4) && file.read((char *)&chunkSize, 4))
+	{
+		if(memcmp(chunkId, "fmt ", 4) == 0)
+		{
+			uint16_t fields[8] = {};
+			file.read((char *)fields, std::min<uint32_t>(chunkSize, 16));
+			file.seekg(chunkSize - std::min<uint32_t>(chunkSize, 16) + (chunkSize & 1), std::ios::cur);
+
+			format = fields[0];
+			clip.channels = fields[1];
+			clip.sampleRate = fields[2] | (fields[3] << 16);
+			bitsPerSample = fields[7];
+		}
+		else if(memcmp(chunkId, "data", 4) == 0)
+		{
+			if(format != 1 || bitsPerSample != 16 || clip.channels < 1 || clip.channels > 2 || clip.sampleRate <= 0)
+			{
+				std::cout << "Unsupported WAV format (16-bit PCM mono or stereo only): " << filename << std::endl;
+				return -1;
+			}
+
+			clip.dataOffset = (size_t)file.tellg();
+			dataBytes = chunkSize;
+			break;
+		}
+		else
+		{
+			file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+		}
+	}
+
+	// Large files are mapped and streamed, small ones read in whole
+	file.seekg(0, std::ios::end);
+	size_t fileSize = (size_t)file.tellg();
+	dataBytes = std::min(dataBytes, fileSize - std::min(fileSize, clip.dataOffset));
+	if(dataBytes > 0 && fileSize >= streamThreshold)
+	{
+		file.close();
+		FILE * mapped = fopen(filename.c_str(), "rb");
+		void * mapping = mapped ? mmap(0, fileSize, PROT_READ, MAP_SHARED, fileno(mapped), 0) : MAP_FAILED;
+		if(mapped)
+			fclose(mapped);
+		if(mapping == MAP_FAILED)
+		{
+			std::cout << "Could not map " << filename << std::endl;
+			return -1;
+		}
+
+		// Nothing is read until a voice plays it
+		madvise(mapping, fileSize, MADV_SEQUENTIAL);
+		clip.mapping = (char *)mapping;
+		clip.mappingSize = fileSize;
+	}
+	else if(dataBytes > 0)
+	{
+		clip.samples.resize(dataBytes / 2);
+		file.seekg(clip.dataOffset);
+		file.read((char *)&clip.samples[0], clip.samples.size() * 2);
+	}
+	clip.frames = (int)(dataBytes / 2 / std::max(clip.channels, 1));
+
+	if(clip.frames < 2)
+	{
+		std::cout << "No samples in " << filename << std::endl;
+		if(clip.mapping)
+			munmap(clip.mapping, clip.mappingSize);
+		return -1;
+	}
+
+	clips.push_back(clip);
+	return (int)clips.size() - 1;
+}
+
+void AudioEngine::setStreamThreshold(size_t bytes)
+{
+	streamThreshold = bytes;
+}
+
+int AudioEngine::getClipCount()
+{
+	return (int)clips.size();
+}
+
+int AudioEngine::getStreamedClipCount()
+{
+	int streamed = 0;
+	for(size_t c = 0; c < clips.size(); c++)
+	{
+		if(clips[c].mapping)
+			streamed++;
+	}
+	return streamed;
+}
+
+/*-------------------------------------------------------// Game Thread //---------------------------------------------------------*/
+
+//! Open the backend on this thread so failures can be reported to the caller
+bool AudioEngine::start(AudioBackend * backend, int sampleRate)
+{
+	stop();
+
+	if(!backend->open(sampleRate))
+	{
+		delete backend;
+		return false;
+	}
+
+	this->backend = backend;
+	this->sampleRate = sampleRate;
+	running = true;
+	thread = std::thread(&AudioEngine::audioLoop, this);
+	return true;
+}
+
+//! Join the audio thread, then close the backend it was writing to
+void AudioEngine::stop()
+{
+	if(!running)
+		return;
+
+	running = false;
+	thread.join();
+
+	for(int v = 0; v < MAX_VOICES; v++)
+	{
+		finishVoice(voices[v]);
+	}
+
+	backend->close();
+	delete backend;
+	backend = 0;
+}
+
+bool AudioEngine::isRunning()
+{
+	return running;
+}
+
+//! Queue a clip to start at the next block
+void AudioEngine::play(int clip, float volume)
+{
+	if(!running || clip < 0 || clip >= (int)clips.size())
+		return;
+
+	Command command;
+	command.type = Command::PLAY;
+	command.clip = clip;
+	command.volume = volume;
+	if(!commands.push(command))
+		droppedCommands++;
+}
+
+//! Queue a stop for every voice
+void AudioEngine::stopAll()
+{
+	if(!running)
+		return;
+
+	Command command;
+	command.type = Command::STOP_ALL;
+	command.clip = -1;
+	command.volume = 0.0f;
+	if(!commands.push(command))
+		droppedCommands++;
+}
+
+int AudioEngine::getActiveVoices()
+{
+	return activeVoices;
+}
+
+unsigned int AudioEngine::getDroppedCommands()
+{
+	return droppedCommands;
+}
+
+//! Mapped pages stay in the page cache after they are released, so mincore() would overstate
+//! what the process holds - the Rss of each mapping in /proc/self/smaps is what it really costs
+AudioEngine::MemoryUsage AudioEngine::getMemoryUsage()
+{
+	MemoryUsage usage;
+	usage.preloadedBytes = 0;
+	usage.streamedBytes = 0;
+	usage.streamedResident = 0;
+
+	for(size_t c = 0; c < clips.size(); c++)
+	{
+		usage.preloadedBytes += clips[c].samples.size() * sizeof(int16_t);
+		usage.streamedBytes += clips[c].mappingSize;
+	}
+	if(usage.streamedBytes == 0)
+		return usage;
+
+	std::ifstream smaps("/proc/self/smaps");
+	std::string line;
+	bool streamedMapping = false;
+	while(std::getline(smaps, line))
+	{
+		char * end;
+		unsigned long long start = strtoull(line.c_str(), &end, 16);
+		if(*end == '-')
+		{
+			// Header line of the next mapping
+			streamedMapping = false;
+			for(size_t c = 0; c < clips.size(); c++)
+			{
+				if(clips[c].mapping && (unsigned long long)(uintptr_t)clips[c].mapping == start)
+					streamedMapping = true;
+			}
+		}
+		else if(streamedMapping && line.compare(0, 4, "Rss:") == 0)
+		{
+			usage.streamedResident += strtoull(line.c_str() + 4, 0, 10) * 1024;
+		}
+	}
+	return usage;
+}
+
+/*-------------------------------------------------------// Audio Thread //--------------------------------------------------------*/
+
+//! Mix and write blocks until stopped - the backend's write() sets the pace
+void AudioEngine::audioLoop()
+{
+	while(running)
+	{
+		applyCommands();
+		mix(outputBuffer, BLOCK_FRAMES);
+
+		if(!backend->write(outputBuffer, BLOCK_FRAMES))
+		{
+			// Keep draining commands in real time rather than letting the queue fill
+			std::cout << "Audio output " << backend->getName() << " failed, continuing muted" << std::endl;
+			backend->close();
+			delete backend;
+			backend = new NullAudioBackend();
+			backend->open(sampleRate);
+		}
+	}
+}
+
+//! Start and stop voices
+void AudioEngine::applyCommands()
+{
+	Command command;
+	while(commands.pop(command))
+	{
+		if(command.type == Command::PLAY)
+		{
+			const Clip & clip = clips[command.clip];
+			Voice & voice = allocateVoice();
+			finishVoice(voice);
+			voice.active = true;
+			voice.clip = command.clip;
+			voice.position = 0.0;
+			voice.step = (double)clip.sampleRate / sampleRate;
+			voice.volume = command.volume;
+			voice.order = voiceOrder++;
+			voice.chunk = -1;
+			advanceStream(voice);
+		}
+		else if(command.type == Command::STOP_ALL)
+		{
+			for(int v = 0; v < MAX_VOICES; v++)
+			{
+				finishVoice(voices[v]);
+			}
+		}
+	}
+}
+
+//! When the voice crosses into a new chunk, drop the ones behind it and start reading the one after
+//! Another voice on the same clip just faults released pages back in from the page cache
+void AudioEngine::advanceStream(Voice & voice)
+{
+	const Clip & clip = clips[voice.clip];
+	if(!clip.mapping)
+		return;
+
+	size_t offset = clip.dataOffset + (size_t)voice.position * clip.channels * sizeof(int16_t);
+	int chunk = (int)(std::min(offset, clip.mappingSize - 1) / STREAM_CHUNK_BYTES);
+	if(chunk == voice.chunk)
+		return;
+
+	for(int c = std::max(voice.chunk, 0); c < chunk; c++)
+	{
+		madvise(clip.mapping + c * STREAM_CHUNK_BYTES, STREAM_CHUNK_BYTES, MADV_DONTNEED);
+	}
+
+	// First chunk of a new voice is read ahead too, so the mixer rarely waits on the disk
+	for(int c = (voice.chunk < 0 ? chunk : chunk + 1); c <= chunk + 1; c++)
+	{
+		size_t start = c * STREAM_CHUNK_BYTES;
+		if(start < clip.mappingSize)
+			madvise(clip.mapping + start, std::min(STREAM_CHUNK_BYTES, clip.mappingSize - start), MADV_WILLNEED);
+	}
+	voice.chunk = chunk;
+}
+
+//! Release the stream chunks a voice still holds
+void AudioEngine::finishVoice(Voice & voice)
+{
+	if(voice.active && clips[voice.clip].mapping && voice.chunk >= 0)
+	{
+		const Clip & clip = clips[voice.clip];
+		for(int c = voice.chunk; c <= voice.chunk + 1; c++)
+		{
+			size_t start = c * STREAM_CHUNK_BYTES;
+			if(start < clip.mappingSize)
+				madvise(clip.mapping + start, std::min(STREAM_CHUNK_BYTES, clip.mappingSize - start), MADV_DONTNEED);
+		}
+	}
+	voice.active = false;
+}
+
+//! A free voice, or the one that has been playing longest
+AudioEngine::Voice & AudioEngine::allocateVoice()
+{
+	int oldest = 0;
+	for(int v = 0; v < MAX_VOICES; v++)
+	{
+		if(!voices[v].active)
+			return voices[v];
+		if(voices[v].order - voiceOrder < voices[oldest].order - voiceOrder)
+			oldest = v;
+	}
+	return voices[oldest];
+}
+
+//! Sum the voices in float with linear interpolation between clip frames, then clip to 16 bits
+void AudioEngine::mix(int16_t * output, int frameCount)
+{
+	memset(mixBuffer, 0, sizeof(float) * frameCount * 2);
+
+	int playing = 0;
+	for(int v = 0; v < MAX_VOICES; v++)
+	{
+		Voice & voice = voices[v];
+		if(!voice.active)
+			continue;
+
+		const Clip & clip = clips[voice.clip];
+		const int16_t * samples = clip.mapping ? (const int16_t *)(clip.mapping + clip.dataOffset) : &clip.samples[0];
+		const int last = clip.frames - 1;
+		const float gain = voice.volume / 32768.0f;
+
+		for(int f = 0; f < frameCount; f++)
+		{
+			int frame = (int)voice.position;
+			if(frame >= last)
+			{
+				finishVoice(voice);
+				break;
+			}
+
+			float t = (float)(voice.position - frame);
+			if(clip.channels == 1)
+			{
+				float sample = (samples[frame] + (samples[frame + 1] - samples[frame]) * t) * gain;
+				mixBuffer[f * 2] += sample;
+				mixBuffer[f * 2 + 1] += sample;
+			}
+			else
+			{
+				const int16_t * a = samples + frame * 2;
+				mixBuffer[f * 2] += (a[0] + (a[2] - a[0]) * t) * gain;
+				mixBuffer[f * 2 + 1] += (a[1] + (a[3] - a[1]) * t) * gain;
+			}
+
+			voice.position += voice.step;
+		}
+
+		if(voice.active)
+		{
+			advanceStream(voice);
+			playing++;
+		}
+	}
+	activeVoices = playing;
+
+	for(int s = 0; s < frameCount * 2; s++)
+	{
+		float sample = mixBuffer[s];
+		if(sample > 1.0f)
+			sample = 1.0f;
+		else if(sample < -1.0f)
+			sample = -1.0f;
+		output[s] = (int16_t)(sample * 32767.0f);
+	}
+}
@@ -0,0 +1,174 @@
+#ifndef AUDIOENGINE_H_
+#define AUDIOENGINE_H_
+
+#include <AudioBackend.h>
+#include <SpscQueue.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * In-process sound effect mixer. WAV files are loaded once up front; play()
+ * only queues a command, so the game thread never touches the disk or
+ * waits on the audio thread. The audio thread drains the queue, mixes
+ * every playing voice into one block, resampling clips to the output
+ * rate as it goes, and hands the block to the backend.
+ *
+ * Files at or above the stream threshold are not read in: they are memory
+ * mapped, and each voice playing one walks through the mapping a fixed-size
+ * chunk at a time, asking the kernel to read the next chunk ahead and to
+ * drop the one it has finished. Only the chunks being played stay resident,
+ * however long the clip.
+ */
+class AudioEngine
+{
+
+public:
+
+	//! Bytes of sound data held in memory
+	struct MemoryUsage
+	{
+		size_t preloadedBytes;		//!< Samples of clips read in whole
+		size_t streamedBytes;		//!< Size of the mapped clips
+		size_t streamedResident;	//!< Mapped bytes actually resident now
+
+		//! Everything resident
+		size_t residentBytes(){ return preloadedBytes + streamedResident; };
+	};
+
+	//! Constructor - nothing loaded, not running
+	AudioEngine();
+
+	//! Destructor - stops the audio thread and closes the backend
+	~AudioEngine();
+
+	//! Load a 16-bit PCM WAV file, returning its clip id or -1. Call before start()
+	int load(const std::string & filename);
+
+	//! Files of at least this many bytes are streamed by later load() calls
+	void setStreamThreshold(size_t bytes);
+
+	//! Clips loaded, and how many of them are streamed
+	int getClipCount();
+	int getStreamedClipCount();
+
+	//! Open the backend (the engine takes ownership) and start mixing
+	bool start(AudioBackend * backend, int sampleRate = 44100);
+
+	//! Stop mixing and close the backend
+	void stop();
+
+	//! True between a successful start() and stop()
+	bool isRunning();
+
+	//! Start a clip - game thread only, never blocks
+	void play(int clip, float volume = 1.0f);
+
+	//! Silence every voice - game thread only, never blocks
+	void stopAll();
+
+	//! Voices that were playing after the last block
+	int getActiveVoices();
+
+	//! Commands lost because the queue was full
+	unsigned int getDroppedCommands();
+
+	//! Resident and mapped audio memory, streamed clips measured by the Rss of their mappings in /proc/self/smaps
+	MemoryUsage getMemoryUsage();
+
+	//! Voices mixed at once, the oldest is cut off for a new one
+	static const int MAX_VOICES = 16;
+
+	//! Frames mixed per block, about 12 ms at 44.1 kHz
+	static const int BLOCK_FRAMES = 512;
+
+	//! Default stream threshold - the long stage, world clear and game over jingles stream
+	static const size_t DEFAULT_STREAM_THRESHOLD = 128 * 1024;
+
+	//! Bytes of a streamed file read ahead and released at a time, a multiple of the page size
+	static const size_t STREAM_CHUNK_BYTES = 64 * 1024;
+
+private:
+
+	//! Samples of one loaded file in its own format
+	struct Clip
+	{
+		std::string name;
+		int sampleRate;
+		int channels;
+		int frames;
+		std::vector<int16_t> samples;	//!< Preloaded samples
+		char * mapping;					//!< Whole file when streamed, otherwise null
+		size_t mappingSize;
+		size_t dataOffset;				//!< Byte offset of the samples in the file
+	};
+
+	//! Request from the game thread
+	struct Command
+	{
+		enum Type
+		{
+			PLAY,
+			STOP_ALL
+		};
+
+		Type type;
+		int clip;
+		float volume;
+	};
+
+	//! A clip being played
+	struct Voice
+	{
+		bool active;
+		int clip;
+		double position;	//!< Frame in the clip, fractional when resampling
+		double step;		//!< Clip frames per output frame
+		float volume;
+		unsigned int order;	//!< When it started, to find the oldest
+		int chunk;			//!< Stream chunk being played, -1 for preloaded clips
+	};
+
+	//! Audio thread body
+	void audioLoop();
+
+	//! Apply queued commands
+	void applyCommands();
+
+	//! Mix one block into output
+	void mix(int16_t * output, int frameCount);
+
+	//! Claim a voice, stealing the oldest when all are busy
+	Voice & allocateVoice();
+
+	//! Read ahead and release stream chunks as a voice moves through its clip
+	void advanceStream(Voice & voice);
+
+	//! Voice is done with its clip
+	void finishVoice(Voice & voice);
+
+	std::vector<Clip> clips;
+	size_t streamThreshold;
+
+	AudioBackend * backend;
+	int sampleRate;
+
+	std::thread thread;
+	std::atomic<bool> running;
+
+	SpscQueue<Command, 64> commands;
+	std::atomic<unsigned int> droppedCommands;
+
+	// Audio thread only
+	Voice voices[MAX_VOICES];
+	unsigned int voiceOrder;
+	float mixBuffer[BLOCK_FRAMES * 2];
+	int16_t outputBuffer[BLOCK_FRAMES * 2];
+
+	std::atomic<int> activeVoices;
+
+};
+
+#endif
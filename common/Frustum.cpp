@@ -0,0 +1,57 @@
+#include "Frustum.h"
+#include <math.h>
+
+//! Constructor
+Frustum::Frustum()
+{
+	// Degenerate planes that pass every test
+	for(int p = 0; p < 6; p++)
+	{
+		planes[p][0] = 0.f;
+		planes[p][1] = 0.f;
+		planes[p][2] = 0.f;
+		planes[p][3] = 1.f;
+	}
+}
+
+//! Gribb/Hartmann plane extraction - matrix is column major, val[COLUMN][ROW]
+void Frustum::extract(Matrix4x4 & viewProjection)
+{
+	float * m = viewProjection.getPtr();
+
+	for(int i = 0; i < 3; i++)
+	{
+		for(int k = 0; k < 4; k++)
+		{
+			// Row 3 plus / minus row i
+			planes[i*2][k]     = m[k*4 + 3] + m[k*4 + i];
+			planes[i*2 + 1][k] = m[k*4 + 3] - m[k*4 + i];
+		}
+	}
+
+	// Normalise so distances are in world units
+	for(int p = 0; p < 6; p++)
+	{
+		float length = sqrt(planes[p][0]*planes[p][0] + planes[p][1]*planes[p][1] + planes[p][2]*planes[p][2]);
+		if(length > 0.f)
+		{
+			for(int k = 0; k < 4; k++)
+				planes[p][k] /= length;
+		}
+	}
+}
+
+//! Box is outside if its most positive corner is behind any plane
+bool Frustum::intersectsAABB(Vector3f min, Vector3f max)
+{
+	for(int p = 0; p < 6; p++)
+	{
+		float x = planes[p][0] >= 0.f ? max.x : min.x;
+		float y = planes[p][1] >= 0.f ? max.y : min.y;
+		float z = planes[p][2] >= 0.f ? max.z : min.z;
+
+		if(planes[p][0]*x + planes[p][1]*y + planes[p][2]*z + planes[p][3] < 0.f)
+			return false;
+	}
+	return true;
+}
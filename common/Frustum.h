@@ -0,0 +1,32 @@
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+#include <Matrix.h>
+#include <Vector.h>
+
+/**
+ * View frustum as six planes extracted from a projection * view matrix,
+ * used to skip drawing objects whose bounding boxes are off screen.
+ */
+class Frustum
+{
+
+public:
+
+	//! Constructor - accepts everything until extract() is called
+	Frustum();
+
+	//! Extract the planes from a combined projection * view matrix
+	void extract(Matrix4x4 & viewProjection);
+
+	//! True if the axis aligned box is at least partly inside the frustum
+	bool intersectsAABB(Vector3f min, Vector3f max);
+
+private:
+
+	//! Planes as (a, b, c, d) with a*x + b*y + c*z + d >= 0 inside: left, right, bottom, top, near, far
+	float planes[6][4];
+
+};
+
+#endif
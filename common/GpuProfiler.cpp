@@ -0,0 +1,110 @@
+#include "GpuProfiler.h"
+#include <string.h>
+#include <iostream>
+
+//! Timer queries are core in 3.3
+bool GpuProfiler::init()
+{
+	supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+	if(!supported)
+		std::cout << "Timer queries not supported, GPU pass timing disabled" << std::endl;
+	return supported;
+}
+
+//! Release queries
+void GpuProfiler::destroy()
+{
+	for(unsigned int i = 0; i < passes.size(); i++)
+		glDeleteQueries(FRAME_LATENCY * 2, &passes[i].queries[0][0]);
+	passes.clear();
+}
+
+//! Read back the oldest slot without blocking
+void GpuProfiler::beginFrame()
+{
+	if(!supported)
+		return;
+
+	frame++;
+	int slot = frame % FRAME_LATENCY;
+
+	for(unsigned int i = 0; i < passes.size(); i++)
+	{
+		Pass & pass = passes[i];
+		if(!pass.issued[slot])
+			continue;
+		pass.issued[slot] = false;
+
+		// Still in flight after FRAME_LATENCY frames - drop the sample rather than stall
+		GLint available = 0;
+		glGetQueryObjectiv(pass.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available)
+			continue;
+
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(pass.queries[slot][0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(pass.queries[slot][1], GL_QUERY_RESULT, &end);
+		pass.ms = pass.ms * 0.9f + (float)((end - start) / 1.0e6) * 0.1f;
+	}
+}
+
+//! Pass lookup by name
+int GpuProfiler::findPass(const char * name)
+{
+	for(unsigned int i = 0; i < passes.size(); i++)
+	{
+		if(passes[i].name == name || strcmp(passes[i].name, name) == 0)
+			return i;
+	}
+
+	Pass pass;
+	pass.name = name;
+	pass.ms = 0.0f;
+	glGenQueries(FRAME_LATENCY * 2, &pass.queries[0][0]);
+	for(int slot = 0; slot < FRAME_LATENCY; slot++)
+		pass.issued[slot] = false;
+	passes.push_back(pass);
+	return (int)passes.size() - 1;
+}
+
+//! Start timestamp
+int GpuProfiler::beginPass(const char * name)
+{
+	if(!supported)
+		return -1;
+
+	int pass = findPass(name);
+	glQueryCounter(passes[pass].queries[frame % FRAME_LATENCY][0], GL_TIMESTAMP);
+	return pass;
+}
+
+//! End timestamp
+void GpuProfiler::endPass(int pass)
+{
+	if(pass < 0)
+		return;
+
+	int slot = frame % FRAME_LATENCY;
+	glQueryCounter(passes[pass].queries[slot][1], GL_TIMESTAMP);
+	passes[pass].issued[slot] = true;
+}
+
+int GpuProfiler::getPassCount()
+{
+	return (int)passes.size();
+}
+
+const char * GpuProfiler::getPassName(int pass)
+{
+	return passes[pass].name;
+}
+
+float GpuProfiler::getPassMs(int pass)
+{
+	return passes[pass].ms;
+}
+
+bool GpuProfiler::isSupported()
+{
+	return supported;
+}
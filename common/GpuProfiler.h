@@ -0,0 +1,101 @@
+#ifndef GPUPROFILER_H_
+#define GPUPROFILER_H_
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <vector>
+
+/**
+ * GPU time per render pass from GL_TIMESTAMP queries. Every pass keeps a
+ * small ring of query pairs so results are read FRAME_LATENCY frames later,
+ * once the GPU has finished, and the CPU never waits on a query.
+ * Passes may nest; they are identified by their (string literal) name.
+ */
+class GpuProfiler
+{
+
+public:
+
+	//! Frames between issuing a query and reading it back
+	static const int FRAME_LATENCY = 4;
+
+	//! Constructor
+	GpuProfiler() : supported(false), frame(0){};
+
+	//! Destructor - queries are released explicitly with destroy()
+	~GpuProfiler(){};
+
+	//! Check for timer query support, returns false if the driver has none
+	bool init();
+
+	//! Delete every query object
+	void destroy();
+
+	//! Collect finished results from the slot about to be reused and start a new frame
+	void beginFrame();
+
+	//! Timestamp the start of a pass, returns a handle for endPass (-1 if unsupported)
+	int beginPass(const char * name);
+
+	//! Timestamp the end of a pass
+	void endPass(int pass);
+
+	//! Number of passes seen so far
+	int getPassCount();
+
+	//! Name of a pass
+	const char * getPassName(int pass);
+
+	//! Smoothed GPU milliseconds of a pass
+	float getPassMs(int pass);
+
+	//! True when the driver supports timer queries
+	bool isSupported();
+
+private:
+
+	//! Query pairs and result of one pass
+	struct Pass
+	{
+		const char * name;
+		GLuint queries[FRAME_LATENCY][2];
+		bool issued[FRAME_LATENCY];
+		float ms;
+	};
+
+	//! Find or create the pass with this name
+	int findPass(const char * name);
+
+	//! Timer queries available
+	bool supported;
+
+	//! Frames started, selects the query slot
+	unsigned int frame;
+
+	//! Every pass in first-use order
+	std::vector<Pass> passes;
+
+};
+
+/**
+ * RAII pass - timestamps the enclosing scope on the GPU
+ */
+class GpuZone
+{
+
+public:
+
+	//! Begin the pass
+	GpuZone(GpuProfiler & profiler, const char * name) : profiler(profiler), pass(profiler.beginPass(name)){};
+
+	//! End the pass
+	~GpuZone() { profiler.endPass(pass); };
+
+private:
+
+	GpuProfiler & profiler;
+	int pass;
+
+};
+
+#endif
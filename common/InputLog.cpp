@@ -0,0 +1,114 @@
+#include "InputLog.h"
+#include <iostream>
+#include <string.h>
+
+//! Write the header
+bool InputLog::openForWrite(const std::string & filename, uint32_t seed, int screenWidth, int screenHeight)
+{
+	file.open(filename.c_str(), std::ios::binary);
+	if(!file)
+	{
+		std::cout << "Could not open input log " << filename << std::endl;
+		return false;
+	}
+
+	memcpy(header.magic, "TKIN", 4);
+	header.version = VERSION;
+	header.seed = seed;
+	header.screenWidth = screenWidth;
+	header.screenHeight = screenHeight;
+	file.write((const char *)&header, sizeof(header));
+
+	recording = true;
+	return true;
+}
+
+//! Append one event
+void InputLog::write(uint32_t tick, EventType type, int key, int state, int x, int y)
+{
+	if(!recording)
+		return;
+
+	Event event;
+	event.tick = tick;
+	event.type = (uint8_t)type;
+	event.key = (uint8_t)key;
+	event.state = (uint8_t)state;
+	event.padding = 0;
+	event.x = (int16_t)x;
+	event.y = (int16_t)y;
+	file.write((const char *)&event, sizeof(event));
+}
+
+//! Terminate the log
+void InputLog::writeEnd(uint32_t tick, uint64_t stateHash)
+{
+	if(!recording)
+		return;
+
+	write(tick, END, 0, 0, 0, 0);
+	file.write((const char *)&stateHash, sizeof(stateHash));
+	file.close();
+	recording = false;
+}
+
+//! Load everything up front so replay never touches the disk
+bool InputLog::openForRead(const std::string & filename)
+{
+	std::ifstream input(filename.c_str(), std::ios::binary);
+	if(!input.read((char *)&header, sizeof(header)) || memcmp(header.magic, "TKIN", 4) != 0 || header.version != VERSION)
+	{
+		std::cout << "Not an input log: " << filename << std::endl;
+		return false;
+	}
+
+	events.clear();
+	cursor = 0;
+	Event event;
+	while(input.read((char *)&event, sizeof(event)))
+	{
+		if(event.type == END)
+		{
+			endTick = event.tick;
+			input.read((char *)&endHash, sizeof(endHash));
+			return true;
+		}
+		events.push_back(event);
+	}
+
+	std::cout << "Input log " << filename << " has no end record" << std::endl;
+	return false;
+}
+
+//! Events are stored in tick order
+const InputLog::Event * InputLog::next(uint32_t tick)
+{
+	if(cursor < events.size() && events[cursor].tick == tick)
+		return &events[cursor++];
+	return NULL;
+}
+
+bool InputLog::isRecording()
+{
+	return recording;
+}
+
+const InputLog::Header & InputLog::getHeader()
+{
+	return header;
+}
+
+uint32_t InputLog::getEndTick()
+{
+	return endTick;
+}
+
+uint64_t InputLog::getEndHash()
+{
+	return endHash;
+}
+
+int InputLog::getEventCount()
+{
+	return (int)events.size();
+}
@@ -0,0 +1,107 @@
+#ifndef INPUTLOG_H_
+#define INPUTLOG_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Binary log of input events stamped with the simulation tick they were
+ * handled before. Replaying the events through the same handlers at the
+ * same ticks reproduces the session exactly.
+ *
+ * Layout: header (magic, version, random seed, screen size), then one
+ * 12-byte record per event, then an end record followed by a 64-bit hash
+ * of the final game state.
+ */
+class InputLog
+{
+
+public:
+
+	//! Kinds of recorded event
+	enum EventType
+	{
+		KEY_DOWN = 0,
+		KEY_UP = 1,
+		MOUSE = 2,
+		MOTION = 3,
+		END = 255
+	};
+
+	//! A single event as stored on disk
+	struct Event
+	{
+		uint32_t tick;
+		uint8_t type;
+		uint8_t key;	// Key for KEY_DOWN/KEY_UP, button for MOUSE
+		uint8_t state;	// Button state for MOUSE
+		uint8_t padding;
+		int16_t x;
+		int16_t y;
+	};
+
+	//! Session parameters the replay must match
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t seed;
+		int32_t screenWidth;
+		int32_t screenHeight;
+	};
+
+	//! Constructor
+	InputLog() : recording(false), cursor(0), endTick(0), endHash(0){};
+
+	//! Destructor
+	~InputLog(){};
+
+	//! Start recording to a file
+	bool openForWrite(const std::string & filename, uint32_t seed, int screenWidth, int screenHeight);
+
+	//! Append an event
+	void write(uint32_t tick, EventType type, int key, int state, int x, int y);
+
+	//! Append the end record with the final state hash and close the file
+	void writeEnd(uint32_t tick, uint64_t stateHash);
+
+	//! Load a whole log for replay
+	bool openForRead(const std::string & filename);
+
+	//! Next event if it belongs to this tick, NULL once the tick has no more events
+	const Event * next(uint32_t tick);
+
+	//! True while recording
+	bool isRecording();
+
+	//! Header of the log being replayed
+	const Header & getHeader();
+
+	//! Tick the recorded session ended on
+	uint32_t getEndTick();
+
+	//! Final state hash of the recorded session
+	uint64_t getEndHash();
+
+	//! Number of events loaded for replay
+	int getEventCount();
+
+	//! Log format version
+	static const uint32_t VERSION = 1;
+
+private:
+
+	std::ofstream file;
+	bool recording;
+
+	Header header;
+	std::vector<Event> events;
+	unsigned int cursor;
+	uint32_t endTick;
+	uint64_t endHash;
+
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "InstanceBuffer.h"
+
+//! Remove all instances
+void InstanceBuffer::clear()
+{
+	matrices.clear();
+}
+
+//! Append an instance transform
+void InstanceBuffer::add(Matrix4x4 & matrix)
+{
+	matrices.push_back(matrix);
+}
+
+//! Grow by count and hand back the new tail
+Matrix4x4 * InstanceBuffer::allocate(int count)
+{
+	size_t first = matrices.size();
+	matrices.resize(first + count);
+	return count > 0 ? &matrices[first] : 0;
+}
+
+//! Number of instances
+int InstanceBuffer::size()
+{
+	return (int)matrices.size();
+}
+
+//! Upload transforms, growing the GPU buffer only when needed
+void InstanceBuffer::upload()
+{
+	if(buffer == 0)
+	{
+		glGenBuffers(1, &buffer);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	if(matrices.size() > capacity)
+	{
+		capacity = matrices.size();
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Matrix4x4), &matrices[0], GL_STREAM_DRAW);
+	}
+	else if(matrices.size() > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, matrices.size() * sizeof(Matrix4x4), &matrices[0]);
+	}
+}
+
+//! Bind the matrix columns as instanced attributes
+void InstanceBuffer::bind(GLuint matrixAttribute)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for(int column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(matrixAttribute + column);
+		glVertexAttribPointer(
+			matrixAttribute + column,					// The attribute we want to configure
+			4,											// size
+			GL_FLOAT,									// type
+			GL_FALSE,									// normalized?
+			sizeof(Matrix4x4),							// stride
+			(void*)(sizeof(float) * 4 * column)			// array buffer offset
+		);
+		glVertexAttribDivisor(matrixAttribute + column, 1);
+	}
+}
+
+//! Reset attribute state so other programs are unaffected
+void InstanceBuffer::unbind(GLuint matrixAttribute)
+{
+	for(int column = 0; column < 4; column++)
+	{
+		glVertexAttribDivisor(matrixAttribute + column, 0);
+		glDisableVertexAttribArray(matrixAttribute + column);
+	}
+}
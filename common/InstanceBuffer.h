@@ -0,0 +1,59 @@
+#ifndef INSTANCEBUFFER_H_
+#define INSTANCEBUFFER_H_
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <Matrix.h>
+#include <vector>
+
+/**
+ * Per-instance transform buffer used for instanced drawing.
+ * Matrices are collected on the CPU during the frame, uploaded once and
+ * bound as a mat4 vertex attribute (four vec4 columns, divisor 1).
+ */
+class InstanceBuffer
+{
+
+public:
+
+	//! Constructor
+	InstanceBuffer() : buffer(0), capacity(0){};
+
+	//! Destructor
+	~InstanceBuffer(){};
+
+	//! Remove all instances (keeps GPU storage)
+	void clear();
+
+	//! Append an instance transform
+	void add(Matrix4x4 & matrix);
+
+	//! Append count instances and return them to be filled in, for a batch transform stage to write into
+	Matrix4x4 * allocate(int count);
+
+	//! Number of instances collected this frame
+	int size();
+
+	//! Upload collected transforms to the GPU buffer
+	void upload();
+
+	//! Bind the buffer to the four attribute slots starting at matrixAttribute
+	void bind(GLuint matrixAttribute);
+
+	//! Disable the attribute slots and reset their divisors
+	void unbind(GLuint matrixAttribute);
+
+private:
+
+	//! CPU side copy of the transforms
+	std::vector<Matrix4x4> matrices;
+
+	//! OpenGL Instance Transform Buffer
+	GLuint buffer;
+
+	//! Number of matrices the GPU buffer can currently hold
+	size_t capacity;
+
+};
+
+#endif
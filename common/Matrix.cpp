@@ -3,6 +3,146 @@
 #include <iostream>
 #include <math.h>
 
+// AVX is compiled per function and only used if the CPU reports it
+#ifdef GAME_SSE
+#include <immintrin.h>
+#endif
+
+/*-----------------------------------------------------// SIMD Kernels //----------------------------------------------------------*/
+// Matrices are passed as 16 floats, column after column. Each output column is the lhs columns
+// weighted by one rhs column: out[c] = a0 * b[c][0] + a1 * b[c][1] + a2 * b[c][2] + a3 * b[c][3]
+
+//! The original triple loop
+static void multiplyScalar(const float * a, const float * b, float * out)
+{
+	float result[16];
+	for(int row = 0; row < 4; row++)
+	{
+		for(int col = 0; col < 4; col++)
+		{
+			result[col * 4 + row] =
+				a[0 * 4 + row] * b[col * 4 + 0] +
+				a[1 * 4 + row] * b[col * 4 + 1] +
+				a[2 * 4 + row] * b[col * 4 + 2] +
+				a[3 * 4 + row] * b[col * 4 + 3] ;
+		}
+	}
+	for(int i = 0; i < 16; i++)
+	{
+		out[i] = result[i];
+	}
+}
+
+#ifdef GAME_SSE
+
+//! Column c of a * b
+static inline __m128 multiplyColumnSSE(__m128 a0, __m128 a1, __m128 a2, __m128 a3, __m128 column)
+{
+	__m128 result = _mm_mul_ps(a0, _mm_shuffle_ps(column, column, 0x00));
+	result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_shuffle_ps(column, column, 0x55)));
+	result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_shuffle_ps(column, column, 0xAA)));
+	return _mm_add_ps(result, _mm_mul_ps(a3, _mm_shuffle_ps(column, column, 0xFF)));
+}
+
+//! A single product, unrolled and small enough to inline into multiply()
+static inline void multiplyOneSSE(const float * a, const float * b, float * out)
+{
+	__m128 a0 = _mm_load_ps(a);
+	__m128 a1 = _mm_load_ps(a + 4);
+	__m128 a2 = _mm_load_ps(a + 8);
+	__m128 a3 = _mm_load_ps(a + 12);
+	__m128 b0 = _mm_load_ps(b);
+	__m128 b1 = _mm_load_ps(b + 4);
+	__m128 b2 = _mm_load_ps(b + 8);
+	__m128 b3 = _mm_load_ps(b + 12);
+
+	_mm_store_ps(out, multiplyColumnSSE(a0, a1, a2, a3, b0));
+	_mm_store_ps(out + 4, multiplyColumnSSE(a0, a1, a2, a3, b1));
+	_mm_store_ps(out + 8, multiplyColumnSSE(a0, a1, a2, a3, b2));
+	_mm_store_ps(out + 12, multiplyColumnSSE(a0, a1, a2, a3, b3));
+}
+
+//! One column at a time; b's column is read just before out's is written, so out may alias a or b
+static void multiplySSE(const float * a, const float * b, float * out, int count)
+{
+	__m128 a0 = _mm_loadu_ps(a);
+	__m128 a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8);
+	__m128 a3 = _mm_loadu_ps(a + 12);
+
+	for(int i = 0; i < count * 4; i++)
+	{
+		_mm_storeu_ps(out + i * 4, multiplyColumnSSE(a0, a1, a2, a3, _mm_loadu_ps(b + i * 4)));
+	}
+}
+
+//! Two columns at a time, with each lhs column repeated in both halves of a register
+__attribute__((target("avx")))
+static void multiplyAVX(const float * a, const float * b, float * out, int count)
+{
+	__m256 a0 = _mm256_broadcast_ps((const __m128 *)a);
+	__m256 a1 = _mm256_broadcast_ps((const __m128 *)(a + 4));
+	__m256 a2 = _mm256_broadcast_ps((const __m128 *)(a + 8));
+	__m256 a3 = _mm256_broadcast_ps((const __m128 *)(a + 12));
+
+	for(int i = 0; i < count * 2; i++)
+	{
+		__m256 columns = _mm256_loadu_ps(b + i * 8);
+		__m256 result = _mm256_mul_ps(a0, _mm256_shuffle_ps(columns, columns, 0x00));
+		result = _mm256_add_ps(result, _mm256_mul_ps(a1, _mm256_shuffle_ps(columns, columns, 0x55)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(a2, _mm256_shuffle_ps(columns, columns, 0xAA)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(a3, _mm256_shuffle_ps(columns, columns, 0xFF)));
+		_mm256_storeu_ps(out + i * 8, result);
+	}
+
+	// GCC does not always clear the upper halves when leaving a target("avx") function, and the
+	// SSE code that follows would then stall on every instruction
+	_mm256_zeroupper();
+}
+
+#endif
+
+//! Highest level the CPU and build allow
+static Matrix4x4::SimdLevel detectSimdLevel()
+{
+#ifdef GAME_SSE
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx"))
+		return Matrix4x4::SIMD_AVX;
+	return Matrix4x4::SIMD_SSE;
+#else
+	return Matrix4x4::SIMD_SCALAR;
+#endif
+}
+
+// Constant-initialised so it is valid before any static constructor runs, detected on first use
+static int simdLevel = -1;
+
+Matrix4x4::SimdLevel Matrix4x4::getSimdLevel()
+{
+	if(simdLevel < 0)
+		simdLevel = detectSimdLevel();
+	return (SimdLevel)simdLevel;
+}
+
+void Matrix4x4::setSimdLevel(SimdLevel level)
+{
+	SimdLevel supported = getSupportedSimdLevel();
+	simdLevel = (level < supported) ? level : supported;
+}
+
+Matrix4x4::SimdLevel Matrix4x4::getSupportedSimdLevel()
+{
+	static SimdLevel supported = detectSimdLevel();
+	return supported;
+}
+
+const char * Matrix4x4::getSimdLevelName(SimdLevel level)
+{
+	static const char * names[] = {"scalar", "sse", "avx"};
+	return names[level];
+}
+
 //!Constructor
 Matrix4x4::Matrix4x4()
 {
@@ -10,12 +150,6 @@ Matrix4x4::Matrix4x4()
 	toIdentity();
 }
 
-//! Destructor
-Matrix4x4::~Matrix4x4()
-{
-    //LEAVE BLANK
-}
-
 //! Assignment Constructor
 Matrix4x4::Matrix4x4(
 			float v00,float v10,float v20,float v30,
@@ -39,7 +173,7 @@ void Matrix4x4::toIdentity()
 }
 
 //! Print Matrix with message to ideniify
-void Matrix4x4::print(std::string message)
+void Matrix4x4::print(std::string message) const
 {
 	if(!message.empty())
 	{
@@ -58,7 +192,7 @@ void Matrix4x4::print(std::string message)
 }
 
 //! Set Matrix values using another matrix
-void Matrix4x4::set(Matrix4x4 matrix)
+void Matrix4x4::set(const Matrix4x4 & matrix)
 {
 	val[0][0] = matrix.val[0][0];	val[1][0] = matrix.val[1][0];	val[2][0] = matrix.val[2][0];	val[3][0] = matrix.val[3][0];
 	val[0][1] = matrix.val[0][1];	val[1][1] = matrix.val[1][1];	val[2][1] = matrix.val[2][1];	val[3][1] = matrix.val[3][1];
@@ -66,22 +200,43 @@ void Matrix4x4::set(Matrix4x4 matrix)
 	val[0][3] = matrix.val[0][3];	val[1][3] = matrix.val[1][3];	val[2][3] = matrix.val[2][3];	val[3][3] = matrix.val[3][3];
 }
 
-//!Multiply function usage
-Matrix4x4 Matrix4x4::multiply(Matrix4x4 & lhs, Matrix4x4 & rhs)
+//!Multiply function usage - AVX only pays off over many matrices, so a single product uses SSE
+Matrix4x4 Matrix4x4::multiply(const Matrix4x4 & lhs, const Matrix4x4 & rhs)
 {
 	Matrix4x4 out;
-	for(int row = 0; row < 4; row++)
+#ifdef GAME_SSE
+	if(getSimdLevel() != SIMD_SCALAR)
 	{
-		for(int col = 0; col < 4; col++)
+		multiplyOneSSE(&lhs.val[0][0], &rhs.val[0][0], &out.val[0][0]);
+		return out;
+	}
+#endif
+	multiplyScalar(&lhs.val[0][0], &rhs.val[0][0], &out.val[0][0]);
+	return out;
+}
+
+//! Batch multiply - the level is checked once per call, not per matrix
+void Matrix4x4::multiplyBatch(const Matrix4x4 & lhs, const Matrix4x4 * rhs, Matrix4x4 * out, int count)
+{
+	switch(getSimdLevel())
+	{
+#ifdef GAME_SSE
+	case SIMD_AVX:
+		multiplyAVX(&lhs.val[0][0], &rhs->val[0][0], &out->val[0][0], count);
+		return;
+	case SIMD_SSE:
+		multiplySSE(&lhs.val[0][0], &rhs->val[0][0], &out->val[0][0], count);
+		return;
+#endif
+	default:
+		// A copy of lhs, in case out[i] is lhs and a later matrix still needs it
+		Matrix4x4 left = lhs;
+		for(int i = 0; i < count; i++)
 		{
-			out.val[col][row] = 
-				lhs.val[0][row] * rhs.val[col][0] + 
-				lhs.val[1][row] * rhs.val[col][1] + 
-				lhs.val[2][row] * rhs.val[col][2] + 
-				lhs.val[3][row] * rhs.val[col][3] ;
+			multiplyScalar(&left.val[0][0], &rhs[i].val[0][0], &out[i].val[0][0]);
 		}
+		return;
 	}
-	return out;
 }
 
 //!
@@ -90,13 +245,25 @@ float * Matrix4x4::getPtr()
 	return &val[0][0];
 }
 
+const float * Matrix4x4::getPtr() const
+{
+	return &val[0][0];
+}
+
 //! Multiply Function
-Matrix4x4 Matrix4x4::operator*(Matrix4x4 rhs)
+Matrix4x4 Matrix4x4::operator*(const Matrix4x4 & rhs) const
 {
 	return Matrix4x4::multiply((*this), rhs);
 }
 
-Matrix4x4  Matrix4x4::operator/(float scale)
+//! Multiply in place - the product is complete before this is overwritten
+Matrix4x4 & Matrix4x4::operator*=(const Matrix4x4 & rhs)
+{
+	set(Matrix4x4::multiply(*this, rhs));
+	return *this;
+}
+
+Matrix4x4  Matrix4x4::operator/(float scale) const
 {
     Matrix4x4 out;
     
@@ -107,30 +274,34 @@ Matrix4x4  Matrix4x4::operator/(float scale)
     return out;
 }
 
-//! Scale Function
+//! Scale Function - each column times its scale, what multiplying by diag(x, y, z, 1) gives
 void Matrix4x4::scale(float x, float y, float z)
 {
-    //Create Scale Matrix
-	Matrix4x4 scaleMatrix;
-	scaleMatrix.val[0][0] = x;
-	scaleMatrix.val[1][1] = y;
-	scaleMatrix.val[2][2] = z;	
-	
-    //Set this matrix as results of this multiplied by scale matrix     	
-	set(Matrix4x4::multiply(*this, scaleMatrix));
+	for(int row = 0; row < 4; row++)
+	{
+		val[0][row] *= x;
+		val[1][row] *= y;
+		val[2][row] *= z;
+	}
 }
 
-//! Translate Function
+//! Translate Function - column 3 becomes this * (x, y, z, 1), summed in the order multiply() uses
 void Matrix4x4::translate(float x, float y, float z)
 {
-    //Create Translate Function
-	Matrix4x4 translate;
-	translate.val[3][0] = x;
-	translate.val[3][1] = y;
-	translate.val[3][2] = z;
-    
-    //Set this matrix as results of this multiplied by t     	
-	set(Matrix4x4::multiply(*this, translate));
+#ifdef GAME_SSE
+	if(getSimdLevel() != SIMD_SCALAR)
+	{
+		__m128 column = _mm_mul_ps(_mm_load_ps(val[0]), _mm_set1_ps(x));
+		column = _mm_add_ps(column, _mm_mul_ps(_mm_load_ps(val[1]), _mm_set1_ps(y)));
+		column = _mm_add_ps(column, _mm_mul_ps(_mm_load_ps(val[2]), _mm_set1_ps(z)));
+		_mm_store_ps(val[3], _mm_add_ps(column, _mm_load_ps(val[3])));
+		return;
+	}
+#endif
+	for(int row = 0; row < 4; row++)
+	{
+		val[3][row] = val[0][row] * x + val[1][row] * y + val[2][row] * z + val[3][row];
+	}
 }
 
 //! Rotate Function
@@ -149,15 +320,104 @@ void Matrix4x4::rotate(float angle, float x, float y, float z)
 	float c = cos(rads);
 	float s = sin(rads);
 
-	//Construct Matrix
-	Matrix4x4 rotateMatrix;
-	rotateMatrix.val[0][0] = x*x*(1-c)+c;	rotateMatrix.val[1][0] = x*y*(1-c)-z*s;		rotateMatrix.val[2][0] = x*z*(1-c)+y*s;		rotateMatrix.val[3][0] = 0;
-	rotateMatrix.val[0][1] = y*x*(1-c)+z*s;	rotateMatrix.val[1][1] = y*y*(1-c)+c;		rotateMatrix.val[2][1] = y*z*(1-c)-x*s;		rotateMatrix.val[3][1] = 0;
-	rotateMatrix.val[0][2] = x*z*(1-c)-y*s;	rotateMatrix.val[1][2] = y*z*(1-c)+x*s;		rotateMatrix.val[2][2] = z*z*(1-c)+c;		rotateMatrix.val[3][2] = 0;
-	rotateMatrix.val[0][3] = 0;				rotateMatrix.val[1][3] = 0;					rotateMatrix.val[2][3] = 0;					rotateMatrix.val[3][3] = 1;
-	
-    //Set this matrix as result of this multiplied by rotation     	
-	set(Matrix4x4::multiply(*this, rotateMatrix));	
+	// Upper 3x3 of the rotation matrix, r[column][row]
+	float r[3][3];
+	r[0][0] = x*x*(1-c)+c;		r[1][0] = x*y*(1-c)-z*s;	r[2][0] = x*z*(1-c)+y*s;
+	r[0][1] = y*x*(1-c)+z*s;	r[1][1] = y*y*(1-c)+c;		r[2][1] = y*z*(1-c)-x*s;
+	r[0][2] = x*z*(1-c)-y*s;	r[1][2] = y*z*(1-c)+x*s;	r[2][2] = z*z*(1-c)+c;
+
+	applyRotation(r);
+}
+
+//! Rotate by a quaternion - its rotation matrix, applied like rotate() applies the axis-angle one
+void Matrix4x4::rotate(const Quaternion & q)
+{
+	float r[3][3];
+	r[0][0] = 1 - 2*(q.y*q.y + q.z*q.z);	r[1][0] = 2*(q.x*q.y - q.w*q.z);		r[2][0] = 2*(q.x*q.z + q.w*q.y);
+	r[0][1] = 2*(q.x*q.y + q.w*q.z);		r[1][1] = 1 - 2*(q.x*q.x + q.z*q.z);	r[2][1] = 2*(q.y*q.z - q.w*q.x);
+	r[0][2] = 2*(q.x*q.z - q.w*q.y);		r[1][2] = 2*(q.y*q.z + q.w*q.x);		r[2][2] = 1 - 2*(q.x*q.x + q.y*q.y);
+
+	applyRotation(r);
+}
+
+//! Rotate about X - columns 1 and 2 only
+void Matrix4x4::rotateX(float angle)
+{
+	float rads = angle * (2.f * M_PI)/360.f;
+	rotateColumns(1, 2, cos(rads), sin(rads));
+}
+
+//! Rotate about Y - columns 2 and 0 only
+void Matrix4x4::rotateY(float angle)
+{
+	float rads = angle * (2.f * M_PI)/360.f;
+	rotateColumns(2, 0, cos(rads), sin(rads));
+}
+
+//! Rotate about Z - columns 0 and 1 only
+void Matrix4x4::rotateZ(float angle)
+{
+	float rads = angle * (2.f * M_PI)/360.f;
+	rotateColumns(0, 1, cos(rads), sin(rads));
+}
+
+//! Columns 0-2 become this * r; column 3 is untouched since the rotation has no translation
+void Matrix4x4::applyRotation(const float r[3][3])
+{
+#ifdef GAME_SSE
+	if(getSimdLevel() != SIMD_SCALAR)
+	{
+		__m128 a0 = _mm_load_ps(val[0]);
+		__m128 a1 = _mm_load_ps(val[1]);
+		__m128 a2 = _mm_load_ps(val[2]);
+		for(int col = 0; col < 3; col++)
+		{
+			__m128 column = _mm_mul_ps(a0, _mm_set1_ps(r[col][0]));
+			column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(r[col][1])));
+			_mm_store_ps(val[col], _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(r[col][2]))));
+		}
+		return;
+	}
+#endif
+	float a[3][4];
+	for(int col = 0; col < 3; col++)
+	{
+		for(int row = 0; row < 4; row++)
+		{
+			a[col][row] = val[col][row];
+		}
+	}
+	for(int col = 0; col < 3; col++)
+	{
+		for(int row = 0; row < 4; row++)
+		{
+			val[col][row] = a[0][row] * r[col][0] + a[1][row] * r[col][1] + a[2][row] * r[col][2];
+		}
+	}
+}
+
+//! The other column of an axis rotation is the identity, so it and column 3 are left alone
+void Matrix4x4::rotateColumns(int a, int b, float c, float s)
+{
+#ifdef GAME_SSE
+	if(getSimdLevel() != SIMD_SCALAR)
+	{
+		__m128 columnA = _mm_load_ps(val[a]);
+		__m128 columnB = _mm_load_ps(val[b]);
+		__m128 cosine = _mm_set1_ps(c);
+		__m128 sine = _mm_set1_ps(s);
+		_mm_store_ps(val[a], _mm_add_ps(_mm_mul_ps(columnA, cosine), _mm_mul_ps(columnB, sine)));
+		_mm_store_ps(val[b], _mm_sub_ps(_mm_mul_ps(columnB, cosine), _mm_mul_ps(columnA, sine)));
+		return;
+	}
+#endif
+	for(int row = 0; row < 4; row++)
+	{
+		float va = val[a][row];
+		float vb = val[b][row];
+		val[a][row] = va * c + vb * s;
+		val[b][row] = vb * c - va * s;
+	}
 }
 
 
@@ -257,9 +517,41 @@ void Matrix4x4::lookAt(Vector3f eye, Vector3f center, Vector3f up)
 	this->val[3][3] = 1.0;	
 }
 
+
+//! Transform a point (w = 1)
+Vector3f Matrix4x4::transformPoint(const Vector3f & point) const
+{
+#ifdef GAME_SSE
+	// One lane per output row, summed in the same order as the scalar code
+	if(getSimdLevel() != SIMD_SCALAR)
+	{
+		__m128 result = _mm_mul_ps(_mm_loadu_ps(val[0]), _mm_set1_ps(point.x));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(val[1]), _mm_set1_ps(point.y)));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(val[2]), _mm_set1_ps(point.z)));
+		result = _mm_add_ps(result, _mm_loadu_ps(val[3]));
+
+		return Vector3f(_mm_cvtss_f32(result),
+						_mm_cvtss_f32(_mm_shuffle_ps(result, result, 0x55)),
+						_mm_cvtss_f32(_mm_movehl_ps(result, result)));
+	}
+#endif
+	return Vector3f(
+		val[0][0] * point.x + val[1][0] * point.y + val[2][0] * point.z + val[3][0],
+		val[0][1] * point.x + val[1][1] * point.y + val[2][1] * point.z + val[3][1],
+		val[0][2] * point.x + val[1][2] * point.y + val[2][2] * point.z + val[3][2]);
+}
+
+//! Transform a direction (w = 0)
+Vector3f Matrix4x4::transformDirection(const Vector3f & direction) const
+{
+	return Vector3f(
+		val[0][0] * direction.x + val[1][0] * direction.y + val[2][0] * direction.z,
+		val[0][1] * direction.x + val[1][1] * direction.y + val[2][1] * direction.z,
+		val[0][2] * direction.x + val[1][2] * direction.y + val[2][2] * direction.z);
+}
     
 //!
-Matrix4x4 Matrix4x4::transpose()
+Matrix4x4 Matrix4x4::transpose() const
 {
     Matrix4x4 out;
 
@@ -273,7 +565,7 @@ Matrix4x4 Matrix4x4::transpose()
  
 
 //!
-float Matrix4x4::determinant()
+float Matrix4x4::determinant() const
 {
     return     
     this->val[0][0]*this->val[1][1]*this->val[2][2]*this->val[3][3] + this->val[0][0]*this->val[2][1]*this->val[3][2]*this->val[1][3] + this->val[0][0]*this->val[3][1]*this->val[1][2]*this->val[2][3] +
@@ -287,7 +579,7 @@ float Matrix4x4::determinant()
 }
 
 //!
-Matrix4x4 Matrix4x4::inverse()
+Matrix4x4 Matrix4x4::inverse() const
 {
     #define M(col,row) this->val[col-1][row-1]
     #define M3(r1,c1,r2,c2,r3,c3)M(c1,r1)*M(c2,r2)*M(c3,r3)
@@ -319,17 +611,115 @@ Matrix4x4 Matrix4x4::inverse()
     return a/this->determinant();   
 }
 
+//! Affine check
+bool Matrix4x4::isAffine() const
+{
+	return val[0][3] == 0.0f && val[1][3] == 0.0f && val[2][3] == 0.0f && val[3][3] == 1.0f;
+}
 
+//! [A t; 0 1]^-1 = [A^-1  -A^-1 t; 0 1], with A^-1 from the 3x3 cofactors
+Matrix4x4 Matrix4x4::affineInverse() const
+{
+	// Cofactors of the upper 3x3, c[column][row] of the adjugate
+	float c[3][3];
+	c[0][0] = val[1][1] * val[2][2] - val[2][1] * val[1][2];
+	c[1][0] = val[2][0] * val[1][2] - val[1][0] * val[2][2];
+	c[2][0] = val[1][0] * val[2][1] - val[2][0] * val[1][1];
+	c[0][1] = val[2][1] * val[0][2] - val[0][1] * val[2][2];
+	c[1][1] = val[0][0] * val[2][2] - val[2][0] * val[0][2];
+	c[2][1] = val[2][0] * val[0][1] - val[0][0] * val[2][1];
+	c[0][2] = val[0][1] * val[1][2] - val[1][1] * val[0][2];
+	c[1][2] = val[1][0] * val[0][2] - val[0][0] * val[1][2];
+	c[2][2] = val[0][0] * val[1][1] - val[1][0] * val[0][1];
+
+	float invDet = 1.0f / (val[0][0] * c[0][0] + val[1][0] * c[0][1] + val[2][0] * c[0][2]);
 
+	Matrix4x4 out;
+	for(int col = 0; col < 3; col++)
+	{
+		for(int row = 0; row < 3; row++)
+		{
+			out.val[col][row] = c[col][row] * invDet;
+		}
+	}
 
+	for(int row = 0; row < 3; row++)
+	{
+		out.val[3][row] = -(out.val[0][row] * val[3][0] + out.val[1][row] * val[3][1] + out.val[2][row] * val[3][2]);
+	}
+	return out;
+}
 
 
+/*-------------------------------------------------------// Quaternion //----------------------------------------------------------*/
+//! Constructor
+Quaternion::Quaternion()
+	:w(1), x(0), y(0), z(0)
+{
+}
 
+//! Constructor
+Quaternion::Quaternion(float w, float x, float y, float z)
+	:w(w), x(x), y(y), z(z)
+{
+}
 
+//! (cos(a/2), sin(a/2) * axis)
+Quaternion Quaternion::fromAxisAngle(float angle, float x, float y, float z)
+{
+	float length = sqrt(x*x + y*y + z*z);
+	float halfRads = angle * (float)M_PI/360.f;
+	float s = sin(halfRads) / length;
+	return Quaternion(cos(halfRads), x * s, y * s, z * s);
+}
 
+//! Rotation about X
+Quaternion Quaternion::rotationX(float angle)
+{
+	float halfRads = angle * (float)M_PI/360.f;
+	return Quaternion(cos(halfRads), sin(halfRads), 0, 0);
+}
 
+//! Rotation about Y
+Quaternion Quaternion::rotationY(float angle)
+{
+	float halfRads = angle * (float)M_PI/360.f;
+	return Quaternion(cos(halfRads), 0, sin(halfRads), 0);
+}
 
+//! Rotation about Z
+Quaternion Quaternion::rotationZ(float angle)
+{
+	float halfRads = angle * (float)M_PI/360.f;
+	return Quaternion(cos(halfRads), 0, 0, sin(halfRads));
+}
 
+//! Hamilton product
+Quaternion Quaternion::operator*(const Quaternion & rhs) const
+{
+	return Quaternion(w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+					  w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+					  w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+					  w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w);
+}
 
+//! Conjugate
+Quaternion Quaternion::conjugate() const
+{
+	return Quaternion(w, -x, -y, -z);
+}
 
+//! Normalise
+Quaternion Quaternion::normalise() const
+{
+	float length = sqrt(w*w + x*x + y*y + z*z);
+	return Quaternion(w / length, x / length, y / length, z / length);
+}
 
+//! v + 2w(u x v) + 2u x (u x v), u the vector part
+Vector3f Quaternion::rotate(const Vector3f & v) const
+{
+	Vector3f u(x, y, z);
+	Vector3f t = Vector3f::cross(u, v) * 2.0f;
+	return v + t * w + Vector3f::cross(u, t);
+}
@@ -3,16 +3,84 @@
 
 #include <string>
 
+// SSE is part of every x86-64 CPU, so the matrix, transform and particle code use it wherever the compiler
+// targets it; build with GAME_NO_SIMD to run the scalar code everywhere
+#if defined(__SSE__) && defined(__GNUC__) && !defined(GAME_NO_SIMD)
+#define GAME_SSE
+#endif
+
 //Forward class declaration
 class Vector3f;
 
+/**
+ * Unit quaternion rotation
+ *
+ * A rotation worked out once (one sin and cos of the half angle) and then
+ * reused or composed without further trig - the coin spin shared by every
+ * coin, or a wheel's steer and roll combined into one rotation.
+ */
+class Quaternion
+{
+
+public:
+
+	//! Constructor - identity, no rotation
+	Quaternion();
+
+	//! Constructor - components as given
+	Quaternion(float w, float x, float y, float z);
+
+	//! Rotation of angle degrees about an axis, normalised here
+	static Quaternion fromAxisAngle(float angle, float x, float y, float z);
+
+	//! Rotation of angle degrees about one axis - no normalising needed
+	static Quaternion rotationX(float angle);
+	static Quaternion rotationY(float angle);
+	static Quaternion rotationZ(float angle);
+
+	//! Composition - rhs applied first, as with matrices
+	Quaternion operator*(const Quaternion & rhs) const;
+
+	//! Inverse rotation of a unit quaternion
+	Quaternion conjugate() const;
+
+	//! Rescale to unit length, after many compositions
+	Quaternion normalise() const;
+
+	//! Rotate a vector
+	Vector3f rotate(const Vector3f & v) const;
+
+	//! Values
+	float w, x, y, z;
+
+};
+
 /**
  * 4x4 Matrix class
+ *
+ * multiply(), multiplyBatch() and transformPoint() use SSE or AVX when the
+ * CPU has them, picked once at startup, and fall back to the scalar code
+ * otherwise (or everywhere when built with GAME_NO_SIMD). Every path adds
+ * the products in the same order, so all of them give identical results.
+ *
+ * translate(), scale() and rotate() change the matrix in place and only
+ * touch the columns the operation affects, giving the same result as
+ * multiplying by the full translation, scale or rotation matrix.
+ * rotateX(), rotateY() and rotateZ() skip the axis normalising and the
+ * general 3x3 and only rewrite the two columns an axis rotation changes.
  */
 class Matrix4x4
 {
 
 public:
+
+	//! Instruction sets the multiply and transform functions can use
+	enum SimdLevel
+	{
+		SIMD_SCALAR,
+		SIMD_SSE,
+		SIMD_AVX
+	};
 	
 	//!Constructor
 	Matrix4x4();
@@ -24,46 +92,79 @@ public:
 			float v02,float v12,float v22,float v32,
 			float v03,float v13,float v23,float v33);
 
-	//!Destructor
-	~Matrix4x4();
+	//!Destructor - trivial, so matrices copy and move as plain memory
+	~Matrix4x4() = default;
 
 	//! Creates Identity Matrix
 	void toIdentity();
 
     	//! Set Matrix values
-	void set(Matrix4x4 matrix);
+	void set(const Matrix4x4 & matrix);
 
     	//Return Pointer to first value in matrix - used when passing to opengl uniform
 	float * getPtr();
+	const float * getPtr() const;
 
 	//! Static multiply function
-	static Matrix4x4 multiply(Matrix4x4 & lhs, Matrix4x4 & rhs);
+	static Matrix4x4 multiply(const Matrix4x4 & lhs, const Matrix4x4 & rhs);
 
-    //!
-    Matrix4x4 inverse();
+	//! out[i] = lhs * rhs[i] for count matrices, with lhs loaded once - out may be rhs
+	static void multiplyBatch(const Matrix4x4 & lhs, const Matrix4x4 * rhs, Matrix4x4 * out, int count);
+
+	//! Level in use - the best the CPU supports unless changed with setSimdLevel()
+	static SimdLevel getSimdLevel();
+
+	//! Use a lower level (clamped to what the CPU supports), for benchmarks and comparisons
+	static void setSimdLevel(SimdLevel level);
+
+	//! Best level this CPU and build support
+	static SimdLevel getSupportedSimdLevel();
+
+	//! "scalar", "sse" or "avx"
+	static const char * getSimdLevelName(SimdLevel level);
+
+    //! General inverse through the adjugate and determinant
+    Matrix4x4 inverse() const;
+
+    //! Inverse of a matrix whose last row is (0 0 0 1) - a 3x3 inverse and one transformed column
+    Matrix4x4 affineInverse() const;
+
+    //! True if the last row is exactly (0 0 0 1), as for any mix of translate, rotate and scale
+    bool isAffine() const;
     
     //!
-    Matrix4x4 transpose();
+    Matrix4x4 transpose() const;
     
     //!
-    float determinant();
+    float determinant() const;
 
 	//! Multiply Function
-	Matrix4x4 operator*(Matrix4x4 rhs);
+	Matrix4x4 operator*(const Matrix4x4 & rhs) const;
+
+	//! Multiply in place - this = this * rhs
+	Matrix4x4 & operator*=(const Matrix4x4 & rhs);
 	
 	//
-    Matrix4x4 operator/(float scale);
+    Matrix4x4 operator/(float scale) const;
 
 	//! Print Out Matrix	
-	void print(std::string message = "");
+	void print(std::string message = "") const;
 
-	//! Translate Function
+	//! Translate Function - adds the translation to column 3 only
 	void translate(float x, float y, float z);
 
-	//! Rotate Function
+	//! Rotate Function - angle in degrees about the axis, rewrites columns 0-2 only
 	void rotate(float angle, float x, float y, float z);
+
+	//! Rotate by a quaternion, rewrites columns 0-2 only
+	void rotate(const Quaternion & rotation);
+
+	//! Rotate angle degrees about one axis - one sin/cos, and only the two columns it changes
+	void rotateX(float angle);
+	void rotateY(float angle);
+	void rotateZ(float angle);
 	
-	//!Scale Function
+	//!Scale Function - scales columns 0-2
 	void scale(float x, float y, float z);
 	
 	//! Orthographic Projection Matrix Function 
@@ -75,10 +176,22 @@ public:
 	//! LookAt function
 	void lookAt(Vector3f eye, Vector3f center, Vector3f up);	
 
+	//! Transform a point (w = 1)
+	Vector3f transformPoint(const Vector3f & point) const;
+
+	//! Transform a direction (w = 0)
+	Vector3f transformDirection(const Vector3f & direction) const;
+
 private:
 
-	//! 2D Array containing values: accessed val[COLUMN][ROW]
-	float val[4][4];
+	//! Columns 0-2 become this * r, r the upper 3x3 of a rotation as r[column][row]
+	void applyRotation(const float r[3][3]);
+
+	//! Columns a and b become a * c + b * s and b * c - a * s - the two-column update of an axis rotation
+	void rotateColumns(int a, int b, float c, float s);
+
+	//! 2D Array containing values: accessed val[COLUMN][ROW] - aligned so a column is one SSE load
+	alignas(16) float val[4][4];
 
 };
 
@@ -1,7 +1,10 @@
 #include "Mesh.h"
+#include <cstddef>
+#include <map>
+#include <math.h>
 
 //
-bool Mesh::loadOBJ(std::string filename)
+bool Mesh::loadOBJ(std::string filename, bool createBuffers)
 {
 	/**
 	 * OBJ file format:
@@ -67,150 +70,452 @@ bool Mesh::loadOBJ(std::string filename)
 				<< "\t Tex Coords: " 	<< texcoords.size() << "\n" 
 				<< "\t Faces: " 		<< faces.size() 	<< "\n" << std::endl;
 				
-				
-	initBuffers();
+	if(createBuffers)
+	{
+		initBuffers();
+	}
+	else
+	{
+		// CPU only - still build the indexed data so the cache statistics are available
+		buildIndexedVertices();
+	}
 	return true;
 }
 
-//! Init Vertex array Buffers
-void Mesh::initBuffers()
+/**
+ * Simulate a FIFO post-transform vertex cache and return misses per triangle (ACMR).
+ * 3.0 means every vertex is transformed for every triangle, 0.5 is the practical optimum.
+ */
+static float computeACMR(std::vector<GLuint> & indices, int vertexCount, int cacheSize)
 {
-	std::cout << "Start Init Mesh Buffers" << std::endl;
-	
-	// init buffers
-	glGenBuffers(1, &positionBuffer);
-	glGenBuffers(1, &normalBuffer);
-	glGenBuffers(1, &texcoordBuffer);
-	
-	//Data
-	std::vector<GLfloat> vertexPositionData;
-	std::vector<GLfloat> vertexNormalData;
-	std::vector<GLfloat> vertexTexcoordData;
+	if(indices.size() == 0)
+		return 0.f;
+
+	// Time each vertex entered the cache, FIFO eviction by comparing against the miss counter
+	std::vector<int> cacheTime(vertexCount, -cacheSize - 1);
+	int misses = 0;
+	for(int i = 0; i < indices.size(); i++)
+	{
+		if(misses - cacheTime[indices[i]] > cacheSize)
+		{
+			cacheTime[indices[i]] = misses;
+			misses++;
+		}
+	}
+	return (float)misses / (indices.size() / 3);
+}
+
+/**
+ * Reorder triangles for vertex cache locality (Forsyth, "Linear-Speed Vertex Cache Optimisation").
+ * Greedily emits the triangle whose vertices score highest given a simulated LRU cache.
+ */
+static void optimiseTriangleOrder(std::vector<GLuint> & indices, int vertexCount)
+{
+	const int CACHE_SIZE = 32;
+	int triangleCount = indices.size() / 3;
+	if(triangleCount == 0)
+		return;
+
+	// Vertex -> triangles adjacency
+	std::vector<int> remaining(vertexCount, 0);
+	for(int i = 0; i < indices.size(); i++)
+		remaining[indices[i]]++;
+
+	std::vector<int> adjacencyStart(vertexCount + 1, 0);
+	for(int v = 0; v < vertexCount; v++)
+		adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+
+	std::vector<int> adjacency(indices.size());
+	std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for(int i = 0; i < indices.size(); i++)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	// Per vertex cache position and score, per triangle score
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount, 0.f);
+	std::vector<float> triangleScore(triangleCount, 0.f);
+	std::vector<bool> emitted(triangleCount, false);
+
+	struct Scorer
+	{
+		static float score(int position, int remainingTriangles, int cacheSize)
+		{
+			if(remainingTriangles == 0)
+				return -1.f;
+
+			float value = 0.f;
+			if(position >= 0)
+			{
+				// The last triangle's vertices get a fixed score so it is not simply repeated
+				if(position < 3)
+					value = 0.75f;
+				else
+					value = powf(1.f - (float)(position - 3) / (cacheSize - 3), 1.5f);
+			}
+
+			// Prefer vertices with few triangles left so they are finished off
+			return value + 2.f * powf((float)remainingTriangles, -0.5f);
+		}
+	};
+
+	for(int v = 0; v < vertexCount; v++)
+		vertexScore[v] = Scorer::score(-1, remaining[v], CACHE_SIZE);
+	for(int t = 0; t < triangleCount; t++)
+		triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3+1]] + vertexScore[indices[t*3+2]];
+
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+	std::vector<int> cache;
+	int fallbackCursor = 0;
+	int bestTriangle = 0;
+	for(int t = 1; t < triangleCount; t++)
+		if(triangleScore[t] > triangleScore[bestTriangle])
+			bestTriangle = t;
+
+	while(bestTriangle >= 0)
+	{
+		// Emit the triangle and remove it from its vertices' adjacency
+		emitted[bestTriangle] = true;
+		std::vector<int> newCache;
+		for(int k = 0; k < 3; k++)
+		{
+			GLuint v = indices[bestTriangle*3 + k];
+			output.push_back(v);
+			remaining[v]--;
+
+			int * begin = &adjacency[adjacencyStart[v]];
+			int * end = begin + remaining[v] + 1;
+			for(int * it = begin; it != end; it++)
+			{
+				if(*it == bestTriangle)
+				{
+					*it = *(end - 1);
+					break;
+				}
+			}
+			newCache.push_back(v);
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache
+		for(int i = 0; i < cache.size(); i++)
+		{
+			int v = cache[i];
+			if(v != (int)newCache[0] && v != (int)newCache[1] && v != (int)newCache[2])
+				newCache.push_back(v);
+		}
+
+		// Vertices pushed out of the cache lose their cache score
+		for(int i = CACHE_SIZE; i < newCache.size(); i++)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScore[newCache[i]] = Scorer::score(-1, remaining[newCache[i]], CACHE_SIZE);
+		}
+		if(newCache.size() > CACHE_SIZE)
+			newCache.resize(CACHE_SIZE);
+		cache.swap(newCache);
+
+		// Rescore cached vertices and pick the best triangle touching them
+		for(int i = 0; i < cache.size(); i++)
+		{
+			cachePosition[cache[i]] = i;
+			vertexScore[cache[i]] = Scorer::score(i, remaining[cache[i]], CACHE_SIZE);
+		}
+
+		bestTriangle = -1;
+		float bestScore = -1.f;
+		for(int i = 0; i < cache.size(); i++)
+		{
+			int v = cache[i];
+			for(int a = adjacencyStart[v]; a < adjacencyStart[v] + remaining[v]; a++)
+			{
+				int t = adjacency[a];
+				triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3+1]] + vertexScore[indices[t*3+2]];
+				if(triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		// Nothing connected to the cache - continue with the next unemitted triangle
+		if(bestTriangle < 0)
+		{
+			while(fallbackCursor < triangleCount && emitted[fallbackCursor])
+				fallbackCursor++;
+			if(fallbackCursor < triangleCount)
+				bestTriangle = fallbackCursor;
+		}
+	}
+
+	indices.swap(output);
+}
+
+//! Deduplicate, reorder and fill the interleaved vertex and index arrays
+void Mesh::buildIndexedVertices()
+{
+	vertexData.clear();
+	indexData.clear();
+	indexData.reserve(faces.size() * 3);
+	hasNormals = normals.size() > 0;
+	hasTexcoords = texcoords.size() > 0;
 
-	//Go through each face and add to to lists
+	// One vertex per unique position/normal/texcoord index tuple
+	std::map<std::vector<unsigned int>, GLuint> vertexLookup;
+	std::vector<Vertex> uniqueVertices;
+
+	//Go through each face and add to to list, missing attributes are left zero
 	for(int face_i = 0 ; face_i < faces.size(); face_i++)
 	{
-		Face face = faces[face_i];
+		Face & face = faces[face_i];
 		
 		for(int vertex_i = 0 ; vertex_i < 3; vertex_i++)
 		{
+			std::vector<unsigned int> key(3, 0);
+			if(positions.size() > 0)	key[0] = face.position_index[vertex_i];
+			if(normals.size() > 0)		key[1] = face.normal_index[vertex_i];
+			if(texcoords.size() > 0)	key[2] = face.texturecoord_index[vertex_i];
+
+			std::map<std::vector<unsigned int>, GLuint>::iterator found = vertexLookup.find(key);
+			if(found != vertexLookup.end())
+			{
+				indexData.push_back(found->second);
+				continue;
+			}
+
+			Vertex vertex = {};
+
 			if(positions.size() > 0)
 			{
-				Vector3f v = positions[face.position_index[vertex_i]];
-				vertexPositionData.push_back(v.x);
-				vertexPositionData.push_back(v.y);
-				vertexPositionData.push_back(v.z);
+				Vector3f v = positions[key[0]];
+				vertex.position[0] = v.x;
+				vertex.position[1] = v.y;
+				vertex.position[2] = v.z;
 			}
 			
 			//Add Normals
 			if(normals.size() > 0)
 			{
-				Vector3f n = normals[face.normal_index[vertex_i]];
-				vertexNormalData.push_back(n.x);
-				vertexNormalData.push_back(n.y);
-				vertexNormalData.push_back(n.z);
+				Vector3f n = normals[key[1]];
+				vertex.normal[0] = n.x;
+				vertex.normal[1] = n.y;
+				vertex.normal[2] = n.z;
 			}
 			
 			//Add texture Coords
 			if(texcoords.size() > 0)
 			{
-				Vector2f t = texcoords[face.texturecoord_index[vertex_i]];
-				vertexTexcoordData.push_back(t.x);
-				vertexTexcoordData.push_back(t.y);
+				Vector2f t = texcoords[key[2]];
+				vertex.texcoord[0] = t.x;
+				vertex.texcoord[1] = t.y;
 			}
+
+			GLuint index = uniqueVertices.size();
+			vertexLookup[key] = index;
+			uniqueVertices.push_back(vertex);
+			indexData.push_back(index);
 		}
 	}
-	
-	//Set Data for Position buffer
-	if(positions.size() > 0)
-	{
-		glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
-		glBufferData(GL_ARRAY_BUFFER, vertexPositionData.size() * sizeof(GLfloat), &vertexPositionData[0], GL_STATIC_DRAW);
-	}
-	
-	//Set Data for Normal buffer
-	if(normals.size() > 0)
-	{
-		glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-		glBufferData(GL_ARRAY_BUFFER, vertexNormalData.size() * sizeof(GLfloat), &vertexNormalData[0], GL_STATIC_DRAW);
-	}
 
-	//set data for texcoord buffer
-	if(texcoords.size() > 0)
+	// Reorder triangles for the post-transform cache, keeping the file order if it was already better
+	uniqueVertexCount = uniqueVertices.size();
+	originalACMR = computeACMR(indexData, uniqueVertexCount, VERTEX_CACHE_SIZE);
+	std::vector<GLuint> optimisedIndices = indexData;
+	optimiseTriangleOrder(optimisedIndices, uniqueVertexCount);
+	optimisedACMR = computeACMR(optimisedIndices, uniqueVertexCount, VERTEX_CACHE_SIZE);
+	if(optimisedACMR < originalACMR)
+		indexData.swap(optimisedIndices);
+	else
+		optimisedACMR = originalACMR;
+
+	// Renumber vertices in first-use order so fetches follow the index stream
+	std::vector<int> remap(uniqueVertexCount, -1);
+	vertexData.reserve(uniqueVertexCount);
+	for(int i = 0; i < indexData.size(); i++)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, texcoordBuffer);
-		glBufferData(GL_ARRAY_BUFFER, vertexTexcoordData.size() * sizeof(GLfloat), &vertexTexcoordData[0], GL_STATIC_DRAW);
+		if(remap[indexData[i]] < 0)
+		{
+			remap[indexData[i]] = vertexData.size();
+			vertexData.push_back(uniqueVertices[indexData[i]]);
+		}
+		indexData[i] = remap[indexData[i]];
 	}
-	std::cout << "End Init Mesh Buffers" << std::endl;
+	indexCount = indexData.size();
+}
 
+//! Init Vertex array Buffers
+void Mesh::initBuffers()
+{
+	std::cout << "Start Init Mesh Buffers" << std::endl;
+
+	//Data
+	buildIndexedVertices();
+
+	std::cout 	<< "\t Vertices: " 	<< faces.size() * 3 << " -> " << vertexData.size() << " unique\n"
+				<< "\t ACMR: " 		<< originalACMR 	<< " -> " << optimisedACMR << std::endl;
+
+	uploadBuffers();
+	std::cout << "End Init Mesh Buffers" << std::endl;
 }
 
-//Function to draw a mesh 
-void Mesh::Draw(GLuint vertexPositionAttribute, GLuint vertexNormalAttribute, GLuint vertexTexcordAttribute)
+//! Upload the interleaved and index arrays
+void Mesh::uploadBuffers()
 {
-	// Vertex Position attribute and buffer
-	if(positions.size() > 0)
+	// init buffers and vertex array - reused when the geometry is rebuilt
+	if(vertexArray == 0)
 	{
-		glEnableVertexAttribArray(vertexPositionAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
-		glVertexAttribPointer(
-			vertexPositionAttribute, 		// The attribute we want to configure
-			3,                  			// size
-			GL_FLOAT,        			    // type
-			GL_FALSE,           			// normalized?
-			0,                  			// stride
-			(void*)0            			// array buffer offset
-		);
+		glGenBuffers(1, &vertexBuffer);
+		glGenBuffers(1, &indexBuffer);
+		glGenVertexArrays(1, &vertexArray);
 	}
 
-	if(normals.size() > 0 && vertexNormalAttribute != -1)
+	//Set Data for interleaved and index buffers - the element binding is recorded in the VAO
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	if(vertexData.size() > 0)
 	{
-		glEnableVertexAttribArray(vertexNormalAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-		glVertexAttribPointer(
-			vertexNormalAttribute, 		// The attribute we want to configure
-			3,                 		 	// size
-			GL_FLOAT,           		// type
-			GL_FALSE,           		// normalized?
-			0,                  		// stride
-			(void*)0           			// array buffer offset
-		);
+		glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(Vertex), &vertexData[0], GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size() * sizeof(GLuint), &indexData[0], GL_STATIC_DRAW);
 	}
 
-	if(texcoords.size() > 0 && vertexTexcordAttribute != -1)
+	// Vertex Position attribute
+	glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+	glVertexAttribPointer(
+		POSITION_ATTRIBUTE, 					// The attribute we want to configure
+		3,                  					// size
+		GL_FLOAT,        					    // type
+		GL_FALSE,           					// normalized?
+		sizeof(Vertex),        					// stride
+		(void*)offsetof(Vertex, position)		// array buffer offset
+	);
+
+	// Vertex Normal attribute - left disabled so the shader sees a constant when absent
+	if(hasNormals)
 	{
-		glEnableVertexAttribArray(vertexTexcordAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, texcoordBuffer);
+		glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
 		glVertexAttribPointer(
-			vertexTexcordAttribute, 	// The attribute we want to configure
-			2,                  		// size
-			GL_FLOAT,           		// type
-			GL_FALSE,          			// normalized?
-			0,                 			// stride
-			(void*)0           			// array buffer offset
+			NORMAL_ATTRIBUTE, 					// The attribute we want to configure
+			3,                 		 			// size
+			GL_FLOAT,           				// type
+			GL_FALSE,           				// normalized?
+			sizeof(Vertex),        				// stride
+			(void*)offsetof(Vertex, normal)		// array buffer offset
 		);
 	}
+	else
+	{
+		glDisableVertexAttribArray(NORMAL_ATTRIBUTE);
+	}
 
-	//Draw Arrays
-	glDrawArrays(GL_TRIANGLES, 0, faces.size() * 3); 
-	
-	//Disable Vertex Position Array
-	if(positions.size() > 0)
+	// Vertex TexCoord attribute
+	if(hasTexcoords)
 	{
-		glDisableVertexAttribArray(vertexPositionAttribute);
+		glEnableVertexAttribArray(TEXCOORD_ATTRIBUTE);
+		glVertexAttribPointer(
+			TEXCOORD_ATTRIBUTE, 				// The attribute we want to configure
+			2,                  				// size
+			GL_FLOAT,           				// type
+			GL_FALSE,          					// normalized?
+			sizeof(Vertex),        				// stride
+			(void*)offsetof(Vertex, texcoord)	// array buffer offset
+		);
 	}
-	
-	//Disable Vertex Normal Array
-	if(normals.size() > 0  && vertexNormalAttribute != -1)
+	else
 	{
-		glDisableVertexAttribArray(vertexNormalAttribute);
+		glDisableVertexAttribArray(TEXCOORD_ATTRIBUTE);
 	}
 
-	//Disable Vertex TexCoord Array
-	if(texcoords.size() > 0 && vertexTexcordAttribute != -1)
+	glBindVertexArray(0);
+}
+
+//Function to draw a mesh 
+void Mesh::Draw()
+{
+	Bind();
+	DrawBound();
+}
+
+//! Bind the VAO - attribute layout and index buffer live in it
+void Mesh::Bind()
+{
+	glBindVertexArray(vertexArray);
+}
+
+//! Draw with the VAO already bound
+void Mesh::DrawBound()
+{
+	//Draw Elements
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0);
+}
+
+//Function to draw many copies of a mesh
+void Mesh::DrawInstanced(InstanceBuffer & instances, GLuint matrixAttribute)
+{
+	if(instances.size() <= 0)
+		return;
+
+	glBindVertexArray(vertexArray);
+
+	//Per-instance transforms are attached to this VAO only for the draw
+	instances.bind(matrixAttribute);
+	glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0, instances.size());
+	instances.unbind(matrixAttribute);
+}
+
+//! Merge transformed copies of source into this mesh
+void Mesh::initMerged(Mesh & source, std::vector<Matrix4x4> & transforms)
+{
+	// Only the indexed data is built - the face lists stay empty
+	positions.clear();
+	normals.clear();
+	texcoords.clear();
+	faces.clear();
+	hasNormals = source.hasNormals;
+	hasTexcoords = source.hasTexcoords;
+
+	// Each copy is the source's already deduplicated and cache-ordered data, moved into place
+	int copyVertices = source.vertexData.size();
+	int copyIndices = source.indexData.size();
+	vertexData.resize(copyVertices * transforms.size());
+	indexData.resize(copyIndices * transforms.size());
+
+	for(int copy = 0; copy < transforms.size(); copy++)
 	{
-		glDisableVertexAttribArray(vertexTexcordAttribute);
+		// Positions as points, normals as directions (rigid transforms only)
+		Vertex * vertices = &vertexData[copy * copyVertices];
+		for(int i = 0; i < copyVertices; i++)
+		{
+			vertices[i] = source.vertexData[i];
+
+			const GLfloat * p = vertices[i].position;
+			Vector3f position = transforms[copy].transformPoint(Vector3f(p[0], p[1], p[2]));
+			vertices[i].position[0] = position.x;
+			vertices[i].position[1] = position.y;
+			vertices[i].position[2] = position.z;
+
+			if(hasNormals)
+			{
+				const GLfloat * n = vertices[i].normal;
+				Vector3f normal = Vector3f::normalise(transforms[copy].transformDirection(Vector3f(n[0], n[1], n[2])));
+				vertices[i].normal[0] = normal.x;
+				vertices[i].normal[1] = normal.y;
+				vertices[i].normal[2] = normal.z;
+			}
+		}
+
+		GLuint * indices = &indexData[copy * copyIndices];
+		for(int i = 0; i < copyIndices; i++)
+			indices[i] = source.indexData[i] + copy * copyVertices;
 	}
+
+	// Copies share no vertices, so the cache figures are the source's
+	indexCount = indexData.size();
+	uniqueVertexCount = vertexData.size();
+	originalACMR = source.originalACMR;
+	optimisedACMR = source.optimisedACMR;
+
+	uploadBuffers();
 }
 
 //! Returns Mesh Centroid
@@ -240,6 +545,30 @@ Vector3f Mesh::getMeshCentroid()
 }
 
 
+//! Number of triangles
+int Mesh::getTriangleCount()
+{
+	return indexCount / 3;
+}
+
+//! Number of vertices after deduplication
+int Mesh::getUniqueVertexCount()
+{
+	return uniqueVertexCount;
+}
+
+//! ACMR in file order
+float Mesh::getOriginalACMR()
+{
+	return originalACMR;
+}
+
+//! ACMR after reordering
+float Mesh::getOptimisedACMR()
+{
+	return optimisedACMR;
+}
+
 void Mesh::initTriangle()
 {
 	positions.push_back(Vector3f(-0.5,	-0.5,	0.0));
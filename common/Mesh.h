@@ -4,13 +4,16 @@
 #include <GL/glew.h>
 #include <GL/gl.h>
 #include <Vector.h>
+#include <Matrix.h>
+#include <InstanceBuffer.h>
+#include <VertexAttributes.h>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <fstream>
 
-//! Mesh Class input and rendering
+//! Mesh Class input and rendering - each mesh draws through a vertex array object, so needs OpenGL 3.0 or ARB_vertex_array_object
 class Mesh
 {
 
@@ -18,13 +21,13 @@ class Mesh
 public:
 
     //! Constructor
-    Mesh() : positionBuffer(0), normalBuffer(0), texcoordBuffer(0){};
+    Mesh() : hasNormals(false), hasTexcoords(false), vertexBuffer(0), indexBuffer(0), vertexArray(0), indexCount(0), uniqueVertexCount(0), originalACMR(0.f), optimisedACMR(0.f){};
 
     //! Destructor
     ~Mesh(){};
 
-	//! Load and OBJ mesh from File
-    bool loadOBJ(std::string filename);
+	//! Load and OBJ mesh from File - createBuffers = false only builds the CPU side (no GL context needed)
+    bool loadOBJ(std::string filename, bool createBuffers = true);
 
 	//! Creates geometry for a cube 
 	void initCube();
@@ -34,21 +37,62 @@ public:
 
 	//! Create geometry for triangle
 	void initQuad();
+
+	//! Replace geometry with one copy of source per transform (static batching) - copies the source's indexed data, no rebuild or report
+	void initMerged(Mesh & source, std::vector<Matrix4x4> & transforms);
 	
 
 
-	//!Draw Function for Mesh
-    void Draw(GLuint vertexPositionAttribute, GLuint vertexNormalAttribute = -1, GLuint vertexTexcordAttribute = -1 );
+	//!Draw Function for Mesh - binds the VAO and draws
+    void Draw();
+
+	//! Bind the mesh VAO - lets callers skip redundant binds between draws of the same mesh
+	void Bind();
+
+	//! Draw assuming this mesh's VAO is already bound
+	void DrawBound();
+
+	//!Instanced Draw Function - one copy per transform in instances, bound at matrixAttribute
+	void DrawInstanced(InstanceBuffer & instances, GLuint matrixAttribute);
 
   	//! Returns Mesh Centroid
 	Vector3f getMeshCentroid();
+
+	//! Number of triangles
+	int getTriangleCount();
+
+	//! Number of vertices after deduplication
+	int getUniqueVertexCount();
+
+	//! Average cache miss ratio of the indexed mesh in file order
+	float getOriginalACMR();
+
+	//! Average cache miss ratio after triangle reordering
+	float getOptimisedACMR();
+
+	//! Post-transform cache size used for the ACMR figures
+	static const int VERTEX_CACHE_SIZE = 16;
 	
 //!
 private:
 
-	//! Init
+	//! Interleaved vertex layout: position, normal, tex coord
+	struct Vertex
+	{
+		GLfloat position[3];
+		GLfloat normal[3];
+		GLfloat texcoord[2];
+	};
+
+	//! Init - build the indexed data from the faces, report it and upload it
 	void initBuffers();
 
+	//! Deduplicate face vertices, reorder triangles for the vertex cache and fill the indexed data
+	void buildIndexedVertices();
+
+	//! Upload the indexed data and record the attribute layout in the VAO
+	void uploadBuffers();
+
 	//Face structure
 	struct Face
 	{
@@ -69,16 +113,30 @@ private:
 	//! Mesh Faces
 	std::vector<Face> faces;
 
+	//! Indexed data as uploaded, kept so merged meshes can copy it without rebuilding
+	std::vector<Vertex> vertexData;
+	std::vector<GLuint> indexData;
+	bool hasNormals;
+	bool hasTexcoords;
+
 private:
 
-    //! OpenGL Vertex Positon Buffer
-    GLuint positionBuffer;
- 
-    //! OpenGL Vertex Normal Buffer
-    GLuint normalBuffer;
-     
-    //! OpenGL Vertex Tex Coord Buffer
-    GLuint texcoordBuffer;
+    //! OpenGL Interleaved Vertex Buffer
+    GLuint vertexBuffer;
+
+    //! OpenGL Triangle Index Buffer
+    GLuint indexBuffer;
+
+    //! OpenGL Vertex Array Object holding the attribute layout
+    GLuint vertexArray;
+
+    //! Number of indices in the index buffer
+    GLsizei indexCount;
+
+    //! Cache statistics from the last build
+    int uniqueVertexCount;
+    float originalACMR;
+    float optimisedACMR;
 
 };
 
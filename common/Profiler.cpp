@@ -0,0 +1,160 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Profiler::enabled(false);
+
+namespace
+{
+	//! A finished zone
+	struct Event
+	{
+		const char * name;
+		uint64_t start;
+		uint64_t end;
+		unsigned int frame;
+	};
+
+	//! Ring buffer owned by one thread, written without locking
+	struct ThreadBuffer
+	{
+		int threadID;
+		std::vector<Event> events;
+		std::atomic<uint64_t> written;
+
+		ThreadBuffer(int threadID) : threadID(threadID), events(Profiler::RING_SIZE), written(0){}
+	};
+
+	std::atomic<unsigned int> currentFrame(0);
+
+	//! Every thread that has recorded a zone - buffers live until exit so the dump can read them
+	std::mutex buffersMutex;
+	std::vector<ThreadBuffer *> buffers;
+
+	//! Register the calling thread's buffer on first use
+	ThreadBuffer * threadBuffer()
+	{
+		thread_local ThreadBuffer * buffer = NULL;
+		if(buffer == NULL)
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffer = new ThreadBuffer((int)buffers.size());
+			buffers.push_back(buffer);
+		}
+		return buffer;
+	}
+
+	//! Minimal JSON string escaping for zone names
+	std::string escape(const char * text)
+	{
+		std::string result;
+		for(const char * c = text; *c; c++)
+		{
+			if(*c == '"' || *c == '\\')
+				result += '\\';
+			result += *c;
+		}
+		return result;
+	}
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	Profiler::enabled.store(enabled);
+}
+
+void Profiler::beginFrame()
+{
+	currentFrame++;
+}
+
+unsigned int Profiler::getFrame()
+{
+	return currentFrame.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::record(const char * name, uint64_t start, uint64_t end)
+{
+	ThreadBuffer * buffer = threadBuffer();
+	uint64_t index = buffer->written.load(std::memory_order_relaxed);
+
+	Event & event = buffer->events[index % RING_SIZE];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	event.frame = currentFrame.load(std::memory_order_relaxed);
+
+	// Publish after the event is complete so a concurrent dump never reads a half-written slot
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::writeChromeTrace(const std::string & filename, unsigned int frames)
+{
+	std::ofstream file(filename.c_str());
+	if(!file)
+	{
+		std::cout << "Could not write trace " << filename << std::endl;
+		return false;
+	}
+
+	unsigned int lastFrame = getFrame();
+	unsigned int firstFrame = lastFrame > frames ? lastFrame - frames : 0;
+
+	std::lock_guard<std::mutex> lock(buffersMutex);
+
+	// Timestamps relative to the oldest exported event, in microseconds
+	uint64_t origin = UINT64_MAX;
+	std::vector<std::pair<ThreadBuffer *, std::pair<uint64_t, uint64_t> > > ranges;
+	for(size_t b = 0; b < buffers.size(); b++)
+	{
+		uint64_t written = buffers[b]->written.load(std::memory_order_acquire);
+		uint64_t first = written > (uint64_t)RING_SIZE ? written - RING_SIZE : 0;
+		ranges.push_back(std::make_pair(buffers[b], std::make_pair(first, written)));
+		for(uint64_t i = first; i < written; i++)
+		{
+			Event & event = buffers[b]->events[i % RING_SIZE];
+			if(event.start < origin)
+				origin = event.start;
+		}
+	}
+
+	file << "{\"traceEvents\":[" << std::endl;
+	int zones = 0;
+	for(size_t r = 0; r < ranges.size(); r++)
+	{
+		ThreadBuffer * buffer = ranges[r].first;
+
+		file << (r > 0 ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadID
+			 << ",\"args\":{\"name\":\"" << (buffer->threadID == 0 ? "Main" : "Worker") << " " << buffer->threadID << "\"}}";
+
+		for(uint64_t i = ranges[r].second.first; i < ranges[r].second.second; i++)
+		{
+			Event & event = buffer->events[i % RING_SIZE];
+
+			// Frame 0 holds startup work such as asset loading
+			if(event.frame != 0 && event.frame <= firstFrame)
+				continue;
+
+			file << ",\n{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadID
+				 << ",\"ts\":" << (event.start - origin) / 1000.0
+				 << ",\"dur\":" << (event.end - event.start) / 1000.0
+				 << ",\"args\":{\"frame\":" << event.frame << "}}";
+			zones++;
+		}
+	}
+	file << "\n]}" << std::endl;
+
+	std::cout << "Wrote " << zones << " zones from frames " << firstFrame + 1 << "-" << lastFrame << " to " << filename << std::endl;
+	return true;
+}
@@ -0,0 +1,81 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <stdint.h>
+
+//! Queue a draw
+void RenderQueue::submit(GLuint program, GLint matrixUniform, GLuint texture, Mesh * mesh, Matrix4x4 & modelView)
+{
+	Item item;
+	item.program = program;
+	item.matrixUniform = matrixUniform;
+	item.texture = texture;
+	item.mesh = mesh;
+	item.modelView = modelView;
+
+	order.push_back(std::make_pair(packKey(program, texture, mesh), (int)items.size()));
+	items.push_back(item);
+}
+
+//! 16 bits program | 16 bits texture | 32 bits mesh address
+unsigned long long RenderQueue::packKey(GLuint program, GLuint texture, Mesh * mesh)
+{
+	return ((unsigned long long)(program & 0xFFFF) << 48) |
+		   ((unsigned long long)(texture & 0xFFFF) << 32) |
+		   ((unsigned long long)((uintptr_t)mesh & 0xFFFFFFFF));
+}
+
+//! Sort and submit
+void RenderQueue::flush(RenderStats & stats)
+{
+	std::sort(order.begin(), order.end());
+
+	// Nothing is assumed bound so the first item always sets its state
+	GLuint currentProgram = 0;
+	GLuint currentTexture = 0;
+	Mesh * currentMesh = NULL;
+	bool first = true;
+
+	glActiveTexture(GL_TEXTURE0);
+
+	for(int i = 0; i < order.size(); i++)
+	{
+		Item & item = items[order[i].second];
+
+		if(first || item.program != currentProgram)
+		{
+			glUseProgram(item.program);
+			currentProgram = item.program;
+			stats.programBinds++;
+		}
+
+		if(first || item.texture != currentTexture)
+		{
+			glBindTexture(GL_TEXTURE_2D, item.texture);
+			currentTexture = item.texture;
+			stats.textureBinds++;
+		}
+
+		if(first || item.mesh != currentMesh)
+		{
+			item.mesh->Bind();
+			currentMesh = item.mesh;
+			stats.meshBinds++;
+		}
+
+		first = false;
+
+		glUniformMatrix4fv(item.matrixUniform, 1, false, item.modelView.getPtr());
+		item.mesh->DrawBound();
+		stats.drawCalls++;
+		stats.triangles += item.mesh->getTriangleCount();
+	}
+
+	items.clear();
+	order.clear();
+}
+
+//! Number of queued items
+int RenderQueue::size()
+{
+	return (int)items.size();
+}
@@ -0,0 +1,76 @@
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <Matrix.h>
+#include <Mesh.h>
+#include <vector>
+
+/**
+ * State changes and draw calls issued in a frame
+ */
+struct RenderStats
+{
+	int drawCalls;
+	int programBinds;
+	int textureBinds;
+	int meshBinds;
+	int triangles;
+
+	RenderStats() { reset(); }
+
+	void reset() { drawCalls = programBinds = textureBinds = meshBinds = triangles = 0; }
+
+	int binds() { return programBinds + textureBinds + meshBinds; }
+};
+
+/**
+ * Collects draw items during the frame, sorts them by a packed state key
+ * (program, texture, mesh) and submits them with redundant binds skipped.
+ * Only suitable for opaque geometry - submission order is not preserved.
+ */
+class RenderQueue
+{
+
+public:
+
+	//! Constructor
+	RenderQueue(){};
+
+	//! Destructor
+	~RenderQueue(){};
+
+	//! Queue a mesh draw with its program, model view uniform location, texture and transform
+	void submit(GLuint program, GLint matrixUniform, GLuint texture, Mesh * mesh, Matrix4x4 & modelView);
+
+	//! Sort and draw every queued item, counting the binds actually issued, then clear
+	void flush(RenderStats & stats);
+
+	//! Number of queued items
+	int size();
+
+private:
+
+	//! A single queued draw
+	struct Item
+	{
+		GLuint program;
+		GLint matrixUniform;
+		GLuint texture;
+		Mesh * mesh;
+		Matrix4x4 modelView;
+	};
+
+	//! Build the sort key - program in the top bits as it is the most expensive change
+	static unsigned long long packKey(GLuint program, GLuint texture, Mesh * mesh);
+
+	//! Items in submission order
+	std::vector<Item> items;
+
+	//! Sort key and item index pairs, sorted instead of moving whole items
+	std::vector<std::pair<unsigned long long, int> > order;
+
+};
+
+#endif
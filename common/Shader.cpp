@@ -1,4 +1,5 @@
 #include "Shader.h"
+#include "VertexAttributes.h"
 
 #include <GL/glew.h>
 #include <stdio.h>
@@ -106,6 +107,11 @@ GLuint Shader::LoadFromSrc(std::string vertexSrc, std::string fragmentSrc)
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+
+	// Standard vertex attributes use the fixed locations baked into Mesh VAOs
+	glBindAttribLocation(ProgramID, POSITION_ATTRIBUTE, "aVertexPosition");
+	glBindAttribLocation(ProgramID, NORMAL_ATTRIBUTE, "aVertexNormal");
+	glBindAttribLocation(ProgramID, TEXCOORD_ATTRIBUTE, "aVertexTexcoord");
 	glLinkProgram(ProgramID);
 
 
@@ -129,3 +135,151 @@ GLuint Shader::LoadFromSrc(std::string vertexSrc, std::string fragmentSrc)
     //Return Program ID
 	return ProgramID;
 }
+
+
+/**
+ * Compile, link and reflect
+ */
+bool ShaderProgram::loadFromFile(std::string vertexFile, std::string fragmentFile)
+{
+	programID = Shader::LoadFromFile(vertexFile, fragmentFile);
+	if(programID == 0)
+		return false;
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+	if(linked != GL_TRUE)
+		return false;
+
+	reflect();
+	return true;
+}
+
+/**
+ * Build the uniform and attribute tables
+ */
+void ShaderProgram::reflect()
+{
+	uniforms.clear();
+	attributes.clear();
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	std::vector<char> name;
+
+	// Uniforms - block members report location -1
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	name.resize(maxLength + 1);
+	for(GLint i = 0; i < count; i++)
+	{
+		Variable variable;
+		GLsizei length = 0;
+		glGetActiveUniform(programID, i, maxLength, &length, &variable.size, &variable.type, &name[0]);
+		variable.name = std::string(&name[0], length);
+		variable.location = glGetUniformLocation(programID, variable.name.c_str());
+
+		// Arrays are reported as "name[0]" - store them by their base name
+		if(variable.name.size() > 3 && variable.name.compare(variable.name.size() - 3, 3, "[0]") == 0)
+			variable.name.resize(variable.name.size() - 3);
+
+		uniforms.push_back(variable);
+	}
+
+	// Attributes
+	glGetProgramiv(programID, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(programID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+	name.resize(maxLength + 1);
+	for(GLint i = 0; i < count; i++)
+	{
+		Variable variable;
+		GLsizei length = 0;
+		glGetActiveAttrib(programID, i, maxLength, &length, &variable.size, &variable.type, &name[0]);
+		variable.name = std::string(&name[0], length);
+		variable.location = glGetAttribLocation(programID, variable.name.c_str());
+		attributes.push_back(variable);
+	}
+
+	std::sort(uniforms.begin(), uniforms.end());
+	std::sort(attributes.begin(), attributes.end());
+}
+
+/**
+ * Sorted table lookup
+ */
+GLint ShaderProgram::find(std::vector<Variable> & table, const std::string & name)
+{
+	Variable key;
+	key.name = name;
+	std::vector<Variable>::iterator it = std::lower_bound(table.begin(), table.end(), key);
+	if(it != table.end() && it->name == name)
+		return it->location;
+	return -1;
+}
+
+GLint ShaderProgram::uniform(const std::string & name)
+{
+	return find(uniforms, name);
+}
+
+GLint ShaderProgram::attribute(const std::string & name)
+{
+	return find(attributes, name);
+}
+
+/**
+ * Uniform block binding
+ */
+bool ShaderProgram::bindUniformBlock(const std::string & blockName, GLuint bindingPoint)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(programID, blockName.c_str());
+	if(blockIndex == GL_INVALID_INDEX)
+	{
+		std::cout << "Uniform block " << blockName << " not found" << std::endl;
+		return false;
+	}
+	glUniformBlockBinding(programID, blockIndex, bindingPoint);
+	return true;
+}
+
+void ShaderProgram::use()
+{
+	glUseProgram(programID);
+}
+
+GLuint ShaderProgram::getID()
+{
+	return programID;
+}
+
+void ShaderProgram::destroy()
+{
+	glDeleteProgram(programID);
+	programID = 0;
+}
+
+/**
+ * Uniform buffer
+ */
+void UniformBuffer::create(GLsizeiptr size, GLuint bindingPoint)
+{
+	this->size = size;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::update(const void * data)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::destroy()
+{
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
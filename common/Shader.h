@@ -3,6 +3,7 @@
 
 #include <GL/glew.h>
 #include <string>
+#include <vector>
 
 /**
  * Handles input of vertex and fragment shaders from file and src
@@ -20,4 +21,100 @@ public:
 
 };
 
+/**
+ * Linked shader program with its active uniforms and attributes reflected once at link time.
+ * Lookups go to a flat name-sorted table, never to the driver.
+ */
+class ShaderProgram
+{
+
+public:
+
+	//! Constructor
+	ShaderProgram() : programID(0){};
+
+	//! Destructor - the program is released explicitly with destroy()
+	~ShaderProgram(){};
+
+	//! Compile, link and reflect shaders from file
+	bool loadFromFile(std::string vertexFile, std::string fragmentFile);
+
+	//! Delete the GL program
+	void destroy();
+
+	//! Make this the current program
+	void use();
+
+	//! GL program name
+	GLuint getID();
+
+	//! Cached location of an active uniform, -1 if inactive or inside a uniform block
+	GLint uniform(const std::string & name);
+
+	//! Cached location of an active attribute, -1 if inactive
+	GLint attribute(const std::string & name);
+
+	//! Connect a named uniform block to a buffer binding point
+	bool bindUniformBlock(const std::string & blockName, GLuint bindingPoint);
+
+private:
+
+	//! Reflected uniform or attribute
+	struct Variable
+	{
+		std::string name;
+		GLint location;
+		GLenum type;
+		GLint size;
+
+		bool operator<(const Variable & rhs) const { return name < rhs.name; }
+	};
+
+	//! Query every active uniform and attribute
+	void reflect();
+
+	//! Binary search a sorted table
+	static GLint find(std::vector<Variable> & table, const std::string & name);
+
+	//! OpenGL Program
+	GLuint programID;
+
+	//! Active uniforms sorted by name
+	std::vector<Variable> uniforms;
+
+	//! Active attributes sorted by name
+	std::vector<Variable> attributes;
+
+};
+
+/**
+ * Uniform buffer object shared by every program that binds its block to the same binding point
+ */
+class UniformBuffer
+{
+
+public:
+
+	//! Constructor
+	UniformBuffer() : buffer(0), size(0){};
+
+	//! Create the buffer with a fixed size and attach it to bindingPoint
+	void create(GLsizeiptr size, GLuint bindingPoint);
+
+	//! Replace the whole buffer contents
+	void update(const void * data);
+
+	//! Delete the GL buffer
+	void destroy();
+
+private:
+
+	//! OpenGL Uniform Buffer
+	GLuint buffer;
+
+	//! Size in bytes
+	GLsizeiptr size;
+
+};
+
 #endif
@@ -30,6 +30,8 @@ SphericalCameraManipulator::SphericalCameraManipulator()
     this->currentState              = 0;
     this->previousMousePosition[0]  = 0;
     this->previousMousePosition[1]  = 0;
+
+    this->viewDirty                 = true;
 }
 
 //!
@@ -45,13 +47,25 @@ void SphericalCameraManipulator::setPanTiltRadius(float pan, float tilt, float r
     this->tilt      = tilt;
     this->radius    = radius;
     this->enforceRanges();
+    this->viewDirty = true;
 }
 
 //!
-Matrix4x4 SphericalCameraManipulator::apply(Matrix4x4 matrix)
+Matrix4x4 SphericalCameraManipulator::apply(const Matrix4x4 & matrix)
 {
-    Matrix4x4 t = this->transform();
-    return Matrix4x4::multiply(matrix, t );
+    this->getViewMatrix();
+    return Matrix4x4::multiply(matrix, this->viewMatrix);
+}
+
+//!
+const Matrix4x4 & SphericalCameraManipulator::getViewMatrix()
+{
+    if(this->viewDirty)
+    {
+        this->viewMatrix = this->transform();
+        this->viewDirty  = false;
+    }
+    return this->viewMatrix;
 }
 
 //!
@@ -96,6 +110,7 @@ void SphericalCameraManipulator::handleMouseMotion(int x, int y)
 
     //Enforce Ranges
     this->enforceRanges();
+    this->viewDirty = true;
 } 
 
 
@@ -103,6 +118,7 @@ void SphericalCameraManipulator::handleMouseMotion(int x, int y)
 void SphericalCameraManipulator::setFocus(Vector3f focus)
 {
     this->focus = focus;
+    this->viewDirty = true;
 }
 
 //!
@@ -142,7 +158,7 @@ Matrix4x4 SphericalCameraManipulator::transform()
 	//camera centre in world coordinates    
 	Vector3f cVec;
     cVec = aVec * this->radius;    
-    cVec = cVec + this->focus;
+    cVec += this->focus;
 	
 	// Horizontal (side) Vector
     Vector3f hVec;
@@ -161,7 +177,7 @@ Matrix4x4 SphericalCameraManipulator::transform()
     	hVec.y, uVec.y, aVec.y, cVec.y,
     	hVec.z, uVec.z, aVec.z, cVec.z,
     	0,      0,      0,      1.0);
-    m = m.inverse();
+    m = m.affineInverse();
 
     return m;
 }
@@ -185,4 +201,10 @@ float SphericalCameraManipulator::getRadius()
     return this->radius;
 }
 
+//!
+Vector3f SphericalCameraManipulator::getFocus()
+{
+    return this->focus;
+}
+
 
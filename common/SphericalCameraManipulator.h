@@ -20,8 +20,11 @@ public:
     //!
     void setPanTiltRadius(float pan, float tilt, float radius);
     
-    //!
-    Matrix4x4 apply(Matrix4x4 matrix);
+    //! Multiply matrix by the cached view matrix
+    Matrix4x4 apply(const Matrix4x4 & matrix);
+
+    //! Cached view matrix, rebuilt only after the camera has changed
+    const Matrix4x4 & getViewMatrix();
 
     //!
     void handleMouse(int button, int state, int x, int y);
@@ -44,6 +47,9 @@ public:
     //!
     float getRadius();
 
+    //!
+    Vector3f getFocus();
+
 private:
 
     //!
@@ -70,6 +76,9 @@ private:
     float radiusWheelStep;
     float radiusRange[2];
     
+    Matrix4x4 viewMatrix;
+    bool viewDirty;
+
     int currentButton;
     int currentState;
     float previousMousePosition[2];
@@ -0,0 +1,60 @@
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <atomic>
+
+/**
+ * Fixed-size queue for one producer thread and one consumer thread. Neither
+ * side ever locks or allocates: each owns one index and only reads the
+ * other's, so push() is safe to call from the game loop while the audio
+ * thread pops. Capacity must be a power of two; one slot is kept empty.
+ */
+template <typename T, unsigned int Capacity>
+class SpscQueue
+{
+
+public:
+
+	//! Constructor - empty
+	SpscQueue() : head(0), tail(0){};
+
+	//! Producer - false, dropping item, if the queue is full
+	bool push(const T & item)
+	{
+		unsigned int t = tail.load(std::memory_order_relaxed);
+		unsigned int next = (t + 1) & (Capacity - 1);
+		if(next == head.load(std::memory_order_acquire))
+			return false;
+
+		items[t] = item;
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	//! Consumer - false if there was nothing to take
+	bool pop(T & item)
+	{
+		unsigned int h = head.load(std::memory_order_relaxed);
+		if(h == tail.load(std::memory_order_acquire))
+			return false;
+
+		item = items[h];
+		head.store((h + 1) & (Capacity - 1), std::memory_order_release);
+		return true;
+	}
+
+private:
+
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	T items[Capacity];
+
+	//! Next slot to pop, written only by the consumer
+	alignas(64) std::atomic<unsigned int> head;
+
+	//! Next slot to push, written only by the producer
+	alignas(64) std::atomic<unsigned int> tail;
+
+};
+
+#endif
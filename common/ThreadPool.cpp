@@ -0,0 +1,102 @@
+#include "ThreadPool.h"
+
+//! Start threads - 1 workers, the caller makes up the last one
+ThreadPool::ThreadPool(int threads)
+	: job(0), count(0), next(0), done(0), generation(0), active(0), stopping(false)
+{
+	if(threads <= 0)
+	{
+		threads = (int)std::thread::hardware_concurrency();
+		if(threads <= 0)
+			threads = 1;
+	}
+
+	for(int t = 1; t < threads; t++)
+	{
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+}
+
+//! Wake every worker so it sees the stop flag, then join
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for(size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+}
+
+//! Threads taking part in a loop
+int ThreadPool::getThreadCount()
+{
+	return (int)workers.size() + 1;
+}
+
+//! Publish the loop, work on it from this thread too, then wait for the stragglers
+void ThreadPool::parallelFor(int count, const std::function<void(int)> & job)
+{
+	if(count <= 0)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this]{ return active == 0; });
+		this->job = &job;
+		this->count.store(count);
+		next.store(0);
+		done.store(0);
+		generation++;
+	}
+	wake.notify_all();
+
+	runJobs();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this, count]{ return done.load() == count && active == 0; });
+	this->job = 0;
+}
+
+//! Sleep until a new loop is published
+void ThreadPool::workerLoop()
+{
+	unsigned int seen = 0;
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, seen]{ return stopping || generation != seen; });
+			if(stopping)
+				return;
+			seen = generation;
+			active++;
+		}
+
+		runJobs();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if(--active == 0)
+			finished.notify_all();
+	}
+}
+
+//! Claim indices until none are left, the last one finished wakes the caller
+void ThreadPool::runJobs()
+{
+	int index;
+	while((index = next.fetch_add(1)) < count)
+	{
+		(*job)(index);
+
+		if(done.fetch_add(1) + 1 == count)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.notify_all();
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads for data-parallel loops. parallelFor() hands
+ * out indices one at a time from a shared counter, so uneven jobs balance
+ * themselves, and the calling thread works alongside the pool until every
+ * index is done. Workers sleep between loops.
+ */
+class ThreadPool
+{
+
+public:
+
+	//! Constructor - threads counts the caller, 0 uses every hardware thread
+	ThreadPool(int threads = 0);
+
+	//! Destructor - stops and joins the workers
+	~ThreadPool();
+
+	//! Threads taking part in a loop, including the caller
+	int getThreadCount();
+
+	//! Run job(index) for every index in [0, count) and wait for all of them
+	void parallelFor(int count, const std::function<void(int)> & job);
+
+private:
+
+	//! Worker thread body
+	void workerLoop();
+
+	//! Take indices from the current loop until it is exhausted
+	void runJobs();
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+
+	//! Current loop, valid while a parallelFor() is running
+	const std::function<void(int)> * job;
+	std::atomic<int> count;
+	std::atomic<int> next;
+	std::atomic<int> done;
+
+	//! Incremented for every loop so sleeping workers know there is new work
+	unsigned int generation;
+
+	//! Workers inside runJobs() - a loop is only published or finished with none left over
+	int active;
+	bool stopping;
+
+};
+
+#endif
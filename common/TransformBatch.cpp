@@ -0,0 +1,141 @@
+#include "TransformBatch.h"
+#include <algorithm>
+#include <math.h>
+
+// Without SSE the matrices are written one float at a time
+#ifdef GAME_SSE
+#include <immintrin.h>
+#endif
+
+// Matrices are written as one run of floats, as the instance buffer uploads them
+static_assert(sizeof(Matrix4x4) == 16 * sizeof(float), "Matrix4x4 must be 16 packed floats");
+
+//! Double the capacity, starting at one block
+void TransformBatch::grow()
+{
+	size_t capacity = std::max((size_t)BLOCK_SIZE, positionX.size() * 2);
+	positionX.resize(capacity);
+	positionY.resize(capacity);
+	positionZ.resize(capacity);
+	yawAngle.resize(capacity);
+	scaleFactorX.resize(capacity);
+	scaleFactorY.resize(capacity);
+	scaleFactorZ.resize(capacity);
+}
+
+//! Split into blocks, on the pool when there is one and more than one block
+void TransformBatch::compute(Matrix4x4 * out, const Matrix4x4 * view, ThreadPool * pool)
+{
+	int blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	if(pool && blocks > 1)
+	{
+		pool->parallelFor(blocks, [&](int block) {
+			computeBlock(block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE), out, view);
+		});
+		return;
+	}
+
+	for(int block = 0; block < blocks; block++)
+	{
+		computeBlock(block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE), out, view);
+	}
+}
+
+//! Cosine and sine of the last yaw that needed trig, reused until the angle changes
+struct YawCache
+{
+	float yaw, c, s;
+
+	YawCache() : yaw(0.0f), c(1.0f), s(0.0f){};
+
+	//! Most objects have no yaw and the rest come in runs (every coin spins together), so little needs any trig
+	inline void get(float angle, float & cosine, float & sine)
+	{
+		if(angle == 0.0f)
+		{
+			cosine = 1.0f;
+			sine = 0.0f;
+			return;
+		}
+		if(angle != yaw)
+		{
+			float rads = angle * (2.f * M_PI)/360.f;
+			c = cos(rads);
+			s = sin(rads);
+			yaw = angle;
+		}
+		cosine = c;
+		sine = s;
+	}
+};
+
+//! Each matrix written column by column
+void TransformBatch::computeBlock(int begin, int end, Matrix4x4 * out, const Matrix4x4 * view)
+{
+	const float * __restrict x = &positionX[0];
+	const float * __restrict y = &positionY[0];
+	const float * __restrict z = &positionZ[0];
+	const float * __restrict yaw = &yawAngle[0];
+	const float * __restrict sx = &scaleFactorX[0];
+	const float * __restrict sy = &scaleFactorY[0];
+	const float * __restrict sz = &scaleFactorZ[0];
+	float * __restrict matrices = out[begin].getPtr();
+	YawCache yawCache;
+	float c, s;
+
+#ifdef GAME_SSE
+	// With a view, only the columns the model touches are combined:
+	// view * T * S * Ry = [v0*sx*c - v2*sz*s, v1*sy, v0*sx*s + v2*sz*c, v0*x + v1*y + v2*z + v3]
+	if(view)
+	{
+		const float * v = view->getPtr();
+		__m128 v0 = _mm_loadu_ps(v + 0);
+		__m128 v1 = _mm_loadu_ps(v + 4);
+		__m128 v2 = _mm_loadu_ps(v + 8);
+		__m128 v3 = _mm_loadu_ps(v + 12);
+		for(int i = begin; i < end; i++)
+		{
+			yawCache.get(yaw[i], c, s);
+			__m128 cosine = _mm_set1_ps(c);
+			__m128 sine = _mm_set1_ps(s);
+			__m128 column0 = _mm_mul_ps(v0, _mm_set1_ps(sx[i]));
+			__m128 column2 = _mm_mul_ps(v2, _mm_set1_ps(sz[i]));
+			__m128 column3 = _mm_mul_ps(v0, _mm_set1_ps(x[i]));
+			column3 = _mm_add_ps(column3, _mm_mul_ps(v1, _mm_set1_ps(y[i])));
+			column3 = _mm_add_ps(column3, _mm_mul_ps(v2, _mm_set1_ps(z[i])));
+
+			float * m = matrices + (i - begin) * 16;
+			_mm_storeu_ps(m + 0, _mm_sub_ps(_mm_mul_ps(column0, cosine), _mm_mul_ps(column2, sine)));
+			_mm_storeu_ps(m + 4, _mm_mul_ps(v1, _mm_set1_ps(sy[i])));
+			_mm_storeu_ps(m + 8, _mm_add_ps(_mm_mul_ps(column0, sine), _mm_mul_ps(column2, cosine)));
+			_mm_storeu_ps(m + 12, _mm_add_ps(column3, v3));
+		}
+		return;
+	}
+#endif
+
+	// T * S * Ry: the scaled rotation columns and the position, val[column][row] as getPtr() lays it out
+	for(int i = begin; i < end; i++)
+	{
+		yawCache.get(yaw[i], c, s);
+		float * m = matrices + (i - begin) * 16;
+#ifdef GAME_SSE
+		_mm_storeu_ps(m + 0, _mm_setr_ps(sx[i] * c, 0.0f, -sz[i] * s, 0.0f));
+		_mm_storeu_ps(m + 4, _mm_setr_ps(0.0f, sy[i], 0.0f, 0.0f));
+		_mm_storeu_ps(m + 8, _mm_setr_ps(sx[i] * s, 0.0f, sz[i] * c, 0.0f));
+		_mm_storeu_ps(m + 12, _mm_setr_ps(x[i], y[i], z[i], 1.0f));
+#else
+		m[0] = sx[i] * c;	m[4] = 0.0f;	m[8] = sx[i] * s;	m[12] = x[i];
+		m[1] = 0.0f;		m[5] = sy[i];	m[9] = 0.0f;		m[13] = y[i];
+		m[2] = -sz[i] * s;	m[6] = 0.0f;	m[10] = sz[i] * c;	m[14] = z[i];
+		m[3] = 0.0f;		m[7] = 0.0f;	m[11] = 0.0f;		m[15] = 1.0f;
+#endif
+	}
+
+	// Without SSE the view is applied as a full product
+	if(view)
+	{
+		Matrix4x4::multiplyBatch(*view, out + begin, out + begin, end - begin);
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef TRANSFORMBATCH_H_
+#define TRANSFORMBATCH_H_
+
+#include <Matrix.h>
+#include <ThreadPool.h>
+#include <vector>
+
+/**
+ * Transform stage for many similar objects. Positions, yaw angles and
+ * scales are collected as one array per component while the scene is
+ * walked, then every model matrix (translate, scale, then yaw about Y) is
+ * built in one pass straight into the caller's array - an instance buffer,
+ * or a frame's matrices, optionally premultiplied by the view.
+ *
+ * The pass runs in blocks of BLOCK_SIZE objects, which are spread over a
+ * ThreadPool when one is given and there is more than one block. Objects
+ * without a yaw need no trig, and runs with the same yaw share one sin/cos.
+ */
+class TransformBatch
+{
+
+public:
+
+	//! Constructor - empty
+	TransformBatch() : count(0){};
+
+	//! Remove all objects (keeps the storage)
+	void clear(){ count = 0; };
+
+	//! Append an object - yaw in degrees about Y. Inline, as it is called once per object in the gather loop
+	void add(float x, float y, float z, float yaw = 0.0f, float scaleX = 1.0f, float scaleY = 1.0f, float scaleZ = 1.0f)
+	{
+		if(count == (int)positionX.size())
+			grow();
+
+		positionX[count] = x;
+		positionY[count] = y;
+		positionZ[count] = z;
+		yawAngle[count] = yaw;
+		scaleFactorX[count] = scaleX;
+		scaleFactorY[count] = scaleY;
+		scaleFactorZ[count] = scaleZ;
+		count++;
+	}
+
+	//! Number of objects collected
+	int size(){ return count; };
+
+	//! out[i] = view * T * S * Ry for every object - view may be null, pool may be null to run on the caller
+	void compute(Matrix4x4 * out, const Matrix4x4 * view = 0, ThreadPool * pool = 0);
+
+	//! Objects built per job
+	static const int BLOCK_SIZE = 1024;
+
+private:
+
+	//! Double the storage of every array
+	void grow();
+
+	//! Build objects [begin, end)
+	void computeBlock(int begin, int end, Matrix4x4 * out, const Matrix4x4 * view);
+
+	//! One array per component, all sized to the capacity
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> yawAngle;
+	std::vector<float> scaleFactorX, scaleFactorY, scaleFactorZ;
+
+	//! Objects in use at the front of the arrays
+	int count;
+
+};
+
+#endif
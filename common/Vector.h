@@ -1,6 +1,14 @@
 #ifndef VECTOR_H_
 #define VECTOR_H_
 
+#include <math.h>
+
+/**
+ * Small vector types, defined entirely in this header so every operation
+ * can be inlined (and vectorised) at the call site. They are trivially
+ * copyable literal types: constants can be built at compile time and
+ * arrays of them copied as plain memory.
+ */
 
 
 /**
@@ -12,17 +20,23 @@ class Vector2f
 public:
 
 	//!
-	Vector2f()
+	constexpr Vector2f()
 	:x(0),y(0){};
 
 	//!
-	~Vector2f(){};
-	
-	//!
-	Vector2f(float x, float y)
+	constexpr Vector2f(float x, float y)
 		:x(x), y(y){};
 
-	float x, y; 
+	//!
+	constexpr Vector2f operator+(const Vector2f & rhs) const { return Vector2f(x + rhs.x, y + rhs.y); }
+
+	//!
+	constexpr Vector2f operator-(const Vector2f & rhs) const { return Vector2f(x - rhs.x, y - rhs.y); }
+
+	//!
+	constexpr Vector2f operator*(float rhs) const { return Vector2f(x * rhs, y * rhs); }
+
+	float x, y;
 };
 
 
@@ -31,44 +45,55 @@ public:
  */
 class Vector3f
 {
-	
+
 
 public:
 
 	//!
-	Vector3f()
+	constexpr Vector3f()
 	:x(0),y(0),z(0){};
 
 	//!
-	~Vector3f(){};
-	
-	//!
-	Vector3f(float x, float y, float z)
+	constexpr Vector3f(float x, float y, float z)
 		:x(x),y(y),z(z){};
-		
+
 	//!
-	Vector3f operator-(Vector3f rhs);
-	
+	constexpr Vector3f operator-(const Vector3f & rhs) const { return Vector3f(x - rhs.x, y - rhs.y, z - rhs.z); }
+
 	//!
-	Vector3f operator+(Vector3f rhs);
+	constexpr Vector3f operator+(const Vector3f & rhs) const { return Vector3f(x + rhs.x, y + rhs.y, z + rhs.z); }
 
-	//! 
-	Vector3f operator/(float rhs);
+	//!
+	constexpr Vector3f operator/(float rhs) const { return Vector3f(x / rhs, y / rhs, z / rhs); }
 
-    //!    
-	Vector3f operator*(float rhs);
+    //!
+	constexpr Vector3f operator*(float rhs) const { return Vector3f(x * rhs, y * rhs, z * rhs); }
+
+	//! Negation
+	constexpr Vector3f operator-() const { return Vector3f(-x, -y, -z); }
+
+	//! Compound assignment - same arithmetic as the binary operators, without the temporary
+	Vector3f & operator+=(const Vector3f & rhs) { x += rhs.x; y += rhs.y; z += rhs.z; return *this; }
+	Vector3f & operator-=(const Vector3f & rhs) { x -= rhs.x; y -= rhs.y; z -= rhs.z; return *this; }
+	Vector3f & operator*=(float rhs) { x *= rhs; y *= rhs; z *= rhs; return *this; }
+	Vector3f & operator/=(float rhs) { x /= rhs; y /= rhs; z /= rhs; return *this; }
 
 	//! get length of vector
-	float length();
-	
+	float length() const { return sqrtf(x*x + y*y + z*z); }
+
 	//! cross product funstion
-	static Vector3f cross(Vector3f v1, Vector3f v2);
-	
+	static constexpr Vector3f cross(const Vector3f & v1, const Vector3f & v2)
+	{
+		return Vector3f(v1.y * v2.z - v2.y * v1.z,
+						v1.z * v2.x - v2.z * v1.x,
+						v1.x * v2.y - v2.x * v1.y);
+	}
+
 	//! dot product function
-	static float dot(Vector3f v1, Vector3f v2);
+	static constexpr float dot(const Vector3f & v1, const Vector3f & v2) { return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z; }
 
 	//! Normalise function
-	static Vector3f normalise(Vector3f v);
+	static Vector3f normalise(const Vector3f & v) { return v / v.length(); }
 
 	//! Values
 	float x,y,z;
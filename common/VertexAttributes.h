@@ -0,0 +1,12 @@
+#ifndef VERTEXATTRIBUTES_H_
+#define VERTEXATTRIBUTES_H_
+
+//! Fixed vertex attribute locations - bound by Shader before linking and baked into every Mesh VAO
+enum VertexAttribute
+{
+	POSITION_ATTRIBUTE = 0,
+	NORMAL_ATTRIBUTE = 1,
+	TEXCOORD_ATTRIBUTE = 2
+};
+
+#endif
@@ -0,0 +1,1101 @@
+#include "GameState.h"
+#include "GridTraversal.h"
+#include <Profiler.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <math.h>
+
+// Environment
+static const float g = -9.81f;
+
+// Tank start position, the centre of the maze
+static const float centerX = (MAZE_WIDTH - 1);
+static const float centerZ = (MAZE_HEIGHT - 1);
+
+// Tank Movement and Physics
+static const float moveSpeed = 2.0f;
+static const float rotationSpeed = 60.0f; // Degrees per second
+static const float maxSpeed = 10.0f;
+static const float friction = 3.0f;
+static const float wheelRadius = 0.001f;
+static const float steeringSpeed = 10.0f;
+static const float fallSpeed = 140.0f;
+static const float initialJumpVelocity = 5.0f;
+
+// Camera
+static const float cameraDistance = 7.0f;
+
+// Ball
+static const float gravityDelay = 0.2f; // Delay before gravity affects the ball
+
+/*---------------------------------------------------------// Events and Input //--------------------------------------------------*/
+const char * gameSoundFile(GameSound sound)
+{
+	static const char * files[SOUND_COUNT] = {
+		"smb_pause.wav",
+		"smb_jump-super.wav",
+		"smb_gameover.wav",
+		"smb_warning.wav",
+		"smb_coin.wav",
+		"smb_stage_clear.wav",
+		"smb_world_clear.wav",
+		"plankton.wav",
+		"smb_fireball.wav",
+	};
+	return files[sound];
+}
+
+void GameEvents::clear()
+{
+	sounds.clear();
+	tiles.clear();
+	levelLoaded = false;
+	teleported = false;
+	ballFired = false;
+	quit = false;
+}
+
+Input::Input()
+{
+	for (int i = 0; i < 256; i++)
+		keys[i] = false;
+}
+
+void Input::push(InputEvent::Type type, unsigned char key, float x, float y)
+{
+	InputEvent event;
+	event.type = type;
+	event.key = key;
+	event.x = x;
+	event.y = y;
+	events.push_back(event);
+}
+
+static void playSound(GameState & state, GameSound sound)
+{
+	state.events.sounds.push_back(sound);
+}
+
+// rand() replacement kept in the state, so games on different threads do not share a sequence
+static int gameRandom(GameState & state)
+{
+	state.randomSeed = state.randomSeed * 1103515245u + 12345u;
+	return (state.randomSeed >> 16) & 0x7fff;
+}
+
+/*-----------------------------------------------------------// Maze Loading //----------------------------------------------------*/
+// Function to read through a text file to load every level of the maze
+bool loadLevels(GameState & state, const std::string & filename)
+{
+	PROFILE_ZONE("loadLevels");
+
+	std::ifstream file(filename); // Open the maze file for reading
+	if (!file)
+	{
+		std::cerr << "Error: could not open maze file: " << filename << std::endl;
+		return false;
+	}
+
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(file, line))
+		lines.push_back(line);
+
+	bool anyFound = false;
+	for (int level = 1; level <= finalLevel; level++)
+	{
+		std::string targetLevel = "LEVEL " + std::to_string(level); // Construct the LEVEL header string (e.g. "LEVEL 1")
+
+		// Search for the LEVEL header line in the file
+		size_t header = 0;
+		while (header < lines.size() && lines[header].find(targetLevel) == std::string::npos)
+			header++;
+
+		state.levelAvailable[level - 1] = header < lines.size();
+		if (!state.levelAvailable[level - 1])
+			continue;
+		anyFound = true;
+
+		// Read the maze layout after the LEVEL header, missing cells are empty
+		int (*tiles)[MAZE_WIDTH] = state.levels[level - 1];
+		for (int i = 0; i < MAZE_HEIGHT; ++i)
+		{
+			for (int j = 0; j < MAZE_WIDTH; ++j)
+				tiles[i][j] = 0;
+
+			if (header + 1 + i >= lines.size())
+				continue;
+
+			std::istringstream iss(lines[header + 1 + i]); // Use stringstream to parse each line
+			for (int j = 0; j < MAZE_WIDTH; ++j)
+				iss >> tiles[i][j]; // Read integer into the maze cell
+		}
+	}
+
+	return anyFound;
+}
+
+// Copy a loaded level into the maze
+void loadMaze(GameState & state, int level)
+{
+	// If the specified level is not found, display error and exit function
+	if (level < 1 || level > finalLevel || !state.levelAvailable[level - 1])
+	{
+		std::cerr << "Error: Level " << level << " not found in file." << std::endl;
+		return;
+	}
+
+	state.totalCoins = 0; // Reset coin count for the new level
+
+	for (int i = 0; i < MAZE_HEIGHT; ++i)
+	{
+		for (int j = 0; j < MAZE_WIDTH; ++j)
+		{
+			state.MAZE[i][j] = state.levels[level - 1][i][j];
+
+			if (state.MAZE[i][j] == 2)
+			{
+				state.totalCoins++; // Count coin tiles
+			}
+		}
+	}
+
+	// Whole level changed
+	state.events.levelLoaded = true;
+
+	// Print confirmation with the number of coins found
+	if (state.verbose)
+		std::cout << "Level " << level << " loaded with " << state.totalCoins << " coins." << std::endl;
+}
+
+// Change a maze tile and report it to the caller
+static void setMazeTile(GameState & state, int i, int j, int value)
+{
+	TileChange change;
+	change.i = i;
+	change.j = j;
+	change.from = state.MAZE[i][j];
+	change.to = value;
+	state.events.tiles.push_back(change);
+
+	state.MAZE[i][j] = value;
+}
+
+/*------------------------------------------------------// Switching Levels Function //--------------------------------------------*/
+void switchLevel(GameState & state, int direction)
+{
+	// Trigger win state if player advances past the final level
+	if (state.currentLevel == finalLevel)
+	{
+		state.gameWon = true;
+		state.levelComplete = false;
+		if (state.verbose)
+			std::cout << "Game Won" << std::endl;
+		playSound(state, SOUND_WORLD_CLEAR); // Play win sound
+		return;
+	}
+
+	// Increment or decrement the current level
+	state.currentLevel += direction;
+
+	// Wrap around to the last level if going below level 1
+	if (state.currentLevel < 1)
+	{
+		state.currentLevel = 3;
+	}
+
+	// Reset Coin counter for new level
+	state.coinsCollected = 0;
+
+	// Reset tank position to the center of the maze
+	state.tankPosition.x = centerX;
+	state.tankPosition.z = centerZ;
+	state.tankPosition.y = 0.0f;
+	state.events.teleported = true;
+
+	// Reset Time Remaining for new level
+	state.remainingTime = 200;
+
+	// Load maze data for the new level
+	loadMaze(state, state.currentLevel);
+
+	// Output confirmation to console
+	if (state.verbose)
+		std::cout << "Switched to level" << state.currentLevel << std::endl;
+}
+
+void resetGame(GameState & state)
+{
+	// Reset level state
+	state.isGameOver = false;
+	state.remainingTime = 200;
+	state.coinsCollected = 0;
+	state.mainMenu = true;
+	state.fallRotation = 0.0f;
+	loadMaze(state, state.currentLevel);
+
+	// Reset tank position to the center of the maze
+	state.tankPosition.x = centerX;
+	state.tankPosition.z = centerZ;
+	state.tankPosition.y = 0.0f;
+	state.events.teleported = true;
+}
+
+void startLevel(GameState & state, int level)
+{
+	resetGame(state);
+	state.currentLevel = state.selectedLevel = level;
+	loadMaze(state, state.currentLevel);
+	state.mainMenu = false;
+	state.showMenu = false;
+	state.isPaused = false;
+	state.gameWon = false;
+	state.levelComplete = false;
+	state.isfalling = false;
+	state.fallSoundPlayed = false;
+	state.isOnGround = true;
+	state.verticalVelocity = 0.0f;
+}
+
+/*----------------------------------------------------------// Key Presses //------------------------------------------------------*/
+// Menu, level and camera keys - the parts of a key press that change the game
+static void handleKeyPress(GameState & state, unsigned char key)
+{
+	// Toggle in-game menu on ESC key
+	if (key == 27) // esc key code
+	{
+		playSound(state, SOUND_PAUSE);
+		if (!state.gameWon && !state.isGameOver && !state.mainMenu)
+		{
+			state.showMenu = !state.showMenu;
+			state.isPaused = state.showMenu;
+		}
+	}
+
+	/*---------------------------------------------------// Menu Navigation Controls //------------------------------------------------*/
+	if (state.showMenu)
+	{
+		// Load level 1
+		if (key == '1')
+		{
+			state.selectedLevel = 1;
+			state.currentLevel = 1;
+			loadMaze(state, state.selectedLevel);
+			state.showMenu = false;
+			state.isPaused = false;
+		}
+		// Load level 2 if level 1 is completed
+		else if (key == '2')
+		{
+			if (state.levelCompleted[0])
+			{
+				state.selectedLevel = 2;
+				state.currentLevel = 2;
+				loadMaze(state, state.selectedLevel);
+				state.showMenu = false;
+				state.isPaused = false;
+			}
+		}
+		// Load level 3 if levels 1 and 2 are completed
+		else if (key == '3')
+		{
+			if (state.levelCompleted[0] && state.levelCompleted[1])
+			{
+				state.selectedLevel = 3;
+				state.currentLevel = 3;
+				loadMaze(state, state.selectedLevel);
+				state.showMenu = false;
+				state.isPaused = false;
+			}
+		}
+		// Restart levels
+		else if (key == 'r' || key == 'R')
+		{
+			loadMaze(state, state.selectedLevel);
+			state.showMenu = false;
+			state.isPaused = false;
+			resetGame(state);
+			state.fallSoundPlayed = false;
+		}
+		// Quit the game
+		else if (key == 'q' || key == 'Q')
+		{
+			state.events.quit = true;
+			return;
+		}
+	}
+
+	/*-------------------------------------------------------// Main Menu Controls //-----------------------------------------*/
+	if (state.mainMenu)
+	{
+		// Start level 1
+		if (key == '1')
+		{
+			state.selectedLevel = 1;
+			state.currentLevel = 1;
+			loadMaze(state, state.selectedLevel);
+			state.showMenu = false;
+			state.isPaused = false;
+			state.mainMenu = false;
+		}
+		// Start level 2 if level 1 is completed
+		else if (key == '2')
+		{
+			if (state.levelCompleted[0])
+			{
+				state.selectedLevel = 2;
+				state.currentLevel = 2;
+				loadMaze(state, state.selectedLevel);
+				state.showMenu = false;
+				state.isPaused = false;
+				state.mainMenu = false;
+			}
+		}
+		// Start level 3 if levels 1 and 2 are completed
+		else if (key == '3')
+		{
+			if (state.levelCompleted[0] && state.levelCompleted[1])
+			{
+				state.selectedLevel = 3;
+				state.currentLevel = 3;
+				loadMaze(state, state.selectedLevel);
+				state.showMenu = false;
+				state.isPaused = false;
+				state.mainMenu = false;
+			}
+		}
+		// Restart levels from main menu
+		else if (key == 'r' || key == 'R')
+		{
+			loadMaze(state, state.currentLevel);
+			state.showMenu = false;
+			state.isPaused = false;
+			state.mainMenu = false;
+			state.fallSoundPlayed = false;
+			state.currentLevel = 1;
+			resetGame(state);
+		}
+		// Quit the game from main menu
+		else if (key == 'q' || key == 'Q')
+		{
+			state.events.quit = true;
+			return;
+		}
+	}
+
+	/*-------------------------------------------------------// In-Game Controls (when not paused or game over)---------------------*/
+	else if (!state.isPaused && !state.isGameOver)
+	{
+		// Next level
+		if ((key == 'n' || key == 'N') && state.levelComplete && state.currentLevel < 3)
+		{
+			switchLevel(state, 1);
+			state.levelComplete = false;
+		}
+
+		// Previous level
+		if (key == 'p' || key == 'P')
+		{
+			switchLevel(state, -1);
+		}
+		// Enable first-person camera
+		if (key == 'c' || key == 'C')
+		{
+			state.isFirstPerson = true;
+		}
+		// Disable first-person camera (switch to third-person)
+		if (key == 'v' || key == 'V')
+		{
+			state.isFirstPerson = false;
+		}
+	}
+
+	/*------------------------------------------------------------------// Game Over / Victory Screen Controls //---------------------------*/
+	// Reset game
+	if ((state.isGameOver || state.gameWon) && (key == 'r' || key == 'R'))
+	{
+		resetGame(state);
+		state.gameWon = false;
+		state.levelComplete = false;
+		state.fallSoundPlayed = false;
+	}
+	// Quit game
+	if ((state.isGameOver || state.gameWon) && (key == 'q' || key == 'Q'))
+	{
+		state.events.quit = true;
+	}
+}
+
+/*--------------------------------------------------------------// Firing //-------------------------------------------------------*/
+static void fireBall(GameState & state)
+{
+	// Only fire while fewer balls than the limit are in flight
+	if (state.projectiles.size() >= state.shotLimit)
+		return;
+
+	// Calculate direction based on tank and turret rotation
+	float angle = (state.tankRotation + state.turretBaseRotation) * (M_PI / 180.0f);
+	float dirX = sin(angle);
+	float dirZ = cos(angle);
+
+	// Normalise direction vector
+	float length = sqrt(dirX * dirX + dirZ * dirZ);
+	if (length != 0.0f)
+	{
+		dirX /= length;
+		dirZ /= length;
+	}
+
+	// Fire slightly in front of tank barrel, above the tank, with a horizontal directional velocity
+	float offset = 0.8f;
+	Vector3f velocity = Vector3f(dirX, 0.0f, dirZ) * 12.0f;
+	if (state.projectiles.spawn(state.tankPosition.x + dirX * offset, state.tankPosition.y + 2.0f,
+								state.tankPosition.z + dirZ * offset, velocity.x, velocity.z) < 0)
+		return;
+	state.events.ballFired = true;
+
+	// Play firing sound effect
+	playSound(state, SOUND_FIREBALL);
+}
+
+/*-------------------------------------------------------------// Input //---------------------------------------------------------*/
+static void applyInputEvent(GameState & state, const InputEvent & event)
+{
+	if (event.type == InputEvent::KEY_PRESS)
+	{
+		handleKeyPress(state, event.key);
+		return;
+	}
+
+	if (event.type == InputEvent::AIM_MOVE)
+	{
+		// Only process motion if aiming is active, and not while paused or in the main menu
+		if (!state.aiming || state.mainMenu || state.isPaused)
+			return;
+
+		// Calculate desired turret rotation angle in degrees
+		state.targetTurretRotation = atan2(event.x, event.y) * (180.0f / M_PI);
+
+		// Clamp rotation to range [-180, 180] for smooth interpolation
+		if (state.targetTurretRotation > 180.0f)
+			state.targetTurretRotation -= 360.0f;
+		if (state.targetTurretRotation < -180.0f)
+			state.targetTurretRotation += 360.0f;
+		return;
+	}
+
+	// Do not process mouse buttons if the game is paused, over, or in the main menu
+	if (state.isPaused || state.isGameOver || state.mainMenu)
+		return;
+
+	if (event.type == InputEvent::FIRE)
+		fireBall(state); // Fire a ball from the turret
+	else if (event.type == InputEvent::AIM_BEGIN)
+		state.aiming = true; // Enter aiming mode
+	else if (event.type == InputEvent::AIM_END)
+		state.aiming = false; // Exit aiming mode
+}
+
+/*------------------------------------------------// Tank Falling Function //------------------------------------------------------*/
+static void checkfall(GameState & state, float dt)
+{
+	bool onCrate = false;
+
+	// If the tank is already in the air, skip further checkss
+	if (!state.isOnGround)
+		return;
+
+	// Every tile driven over since the tank was last on the ground, not just the one it ended on
+	GridTraversal path(state.groundStart.x, state.groundStart.z, state.tankPosition.x, state.tankPosition.z);
+	int i, j;
+	while (path.next(i, j))
+	{
+		// Make sure the indices are within maze bounds before checking
+		// If the tile has a crate or valid platform (value >= 1), its safe
+		onCrate = i >= 0 && j >= 0 && i < MAZE_WIDTH && j < MAZE_HEIGHT && state.MAZE[i][j] >= 1;
+		if (onCrate)
+			continue;
+
+		// A gap crossed part way through the step - the tank drops into it rather than driving over it
+		if (path.getExit() < 1.0f)
+		{
+			float t = (path.getEntry() + path.getExit()) * 0.5f;
+			state.tankPosition.x = state.groundStart.x + (state.tankPosition.x - state.groundStart.x) * t;
+			state.tankPosition.z = state.groundStart.z + (state.tankPosition.z - state.groundStart.z) * t;
+		}
+		break;
+	}
+
+	// If not on a crate, the tank should fall
+	if (!onCrate)
+	{
+		state.isfalling = true;
+	}
+	else
+	{
+		// Tank is safely grounded on a crate or platform
+		state.isfalling = false;
+		state.tankPosition.y = 0.0f;	 // Reset Y position to ground level
+		state.verticalVelocity = 0.0f; // Reset vertical velocity
+	}
+
+	// If the tank is falling, apply gravity and update vertical position
+	if (state.isfalling)
+	{
+		state.verticalVelocity += g * 10.0f * dt;				// Accelerate downward
+		state.tankPosition.y = state.verticalVelocity * dt; // Update Y position
+
+		state.isGameOver = true; // Trigger game over state
+
+		// Play falling sound once
+		if (!state.fallSoundPlayed)
+		{
+			playSound(state, SOUND_FALL);
+			state.fallSoundPlayed = true;
+		}
+	}
+}
+
+/*------------------------------------------------// Tank Movement Function //-----------------------------------------------------*/
+static void updateTankMovement(GameState & state, float dt)
+{
+	// Apply Turning
+	state.tankRotation = state.tankRotation + state.turnDirection * rotationSpeed * dt;
+
+	// Convert rotation to direction
+	float rad = state.tankRotation * (M_PI / 180.0f);
+	Vector3f forward(sin(rad), 0.0f, cos(rad));
+
+	// Update velocity
+	state.tankVelocity = forward * (moveSpeed * state.moveDirection);
+
+	// Apply Friction if no input
+	if (state.moveDirection == 0.0f)
+	{
+		state.tankVelocity *= 0.9f;
+	}
+
+	// Update tank Position
+	state.tankPosition += state.tankVelocity * dt;
+
+	// Calculate rotation amount
+	state.wheelRotation += (moveSpeed * state.moveDirection * dt) / wheelRadius;
+
+	if (!state.isOnGround)
+	{
+		// Apply gravity
+		state.jumpVelocity += g * dt;
+		state.tankPosition.y += state.jumpVelocity * dt;
+
+		// Check if tank lands
+		if (state.tankPosition.y <= 0.0f)
+		{
+			state.tankPosition.y = 0.0f;
+			state.isOnGround = true;
+			state.isJumping = false;
+			state.jumpVelocity = 0.0f;
+
+			// Only the landing tile counts, the gaps flown over do not
+			state.groundStart = state.tankPosition;
+			checkfall(state, dt);
+		}
+	}
+
+	if (state.isfalling && state.fallRotation < 90.0f)
+	{
+		state.fallRotation += dt * fallSpeed; // fallSpeed could be ~45–90 degrees/sec
+		if (state.fallRotation > 90.0f)
+			state.fallRotation = 90.0f; // Clamp to 90
+	}
+}
+
+/*---------------------------------------------------// HandleKeys Funuction //----------------------------------------------------*/
+static void handleKeys(GameState & state, const bool * keys, float dt)
+{
+	PROFILE_ZONE("handleKeys");
+
+	// If the tank is falling, ignore input and update fall behavior only
+	if (state.isfalling)
+	{
+		state.moveDirection = 0.0f;
+		state.turnDirection = 0.0f;
+		checkfall(state, dt);			// Check if the tank has landed or needs to be reset
+		updateTankMovement(state, dt); // Apply physics update
+
+		return;
+	}
+
+	// Do not handle input if in the main menu or game is paused
+	if (state.mainMenu || state.isPaused || state.isGameOver)
+		return;
+	if (state.levelComplete)
+		return;
+
+	// Handle forward/backward movement (W/S keys)
+	if (keys['w'])
+	{
+		state.moveDirection = 1.0f; // Move forward
+	}
+	else if (keys['s'])
+	{
+		state.moveDirection = -1.0f; // Move backward
+	}
+	else
+	{
+		state.moveDirection = 0.0f; // No movement
+	}
+
+	// Apply friction if tank exceeds maximum speed
+	if (state.tankVelocity.length() > maxSpeed)
+	{
+		// Reduce velocity by a factor of friction and time
+		state.tankVelocity -= state.tankVelocity * friction * dt;
+	}
+
+	// Update tank position using velocity and dt
+	state.tankPosition.x += state.tankVelocity.x * dt;
+	state.tankPosition.y += state.tankVelocity.y * dt;
+	state.tankPosition.z += state.tankVelocity.z * dt;
+
+	// Handle turning left/right (A/D keys)
+	if (keys['a'])
+	{
+		state.turnDirection = 1.0f; // Turn Left
+	}
+	else if (keys['d'])
+	{
+		state.turnDirection = -1.0f; // Turn right
+	}
+	else
+	{
+		state.turnDirection = 0.0f; // No turning
+	}
+
+	// Handle jumping (Spacebar)
+	if (keys[' '])
+	{
+		// Can only jump if currently on the ground
+		if (state.isOnGround)
+		{
+			state.isJumping = true;
+			state.isOnGround = false;
+			state.jumpVelocity = initialJumpVelocity; // Apply initial upward force
+			playSound(state, SOUND_JUMP);			   // Play jump sound
+		}
+	}
+
+	// Apply final tank physics update and check for falling conditions
+	updateTankMovement(state, dt);
+	checkfall(state, dt);
+}
+
+/*-------------------------------------------------------// Coin Collection //-----------------------------------------------------*/
+// Shared by the ball and the tank - count the coin and finish the level when it was the last one
+static void collectCoin(GameState & state)
+{
+	state.coinsCollected++; // Increment the player's score
+
+	// Play the coin collected sound
+	playSound(state, SOUND_COIN);
+
+	if (state.verbose)
+		std::cout << "Coins Collected: " << state.coinsCollected << std::endl;
+
+	// If all coins are collected, mark level as complete
+	if (state.coinsCollected == state.totalCoins)
+	{
+		state.levelCompleted[state.currentLevel - 1] = true;
+		state.levelComplete = true;
+
+		if (state.currentLevel == 3)
+		{
+			state.gameWon = true;
+			playSound(state, SOUND_WORLD_CLEAR); // Play win sound
+		}
+		if (state.currentLevel < 3)
+		{
+			playSound(state, SOUND_STAGE_CLEAR); // Victory sound
+		}
+		state.coinsCollected = 0; // Reset for next level
+	}
+}
+
+/*-----------------------------------------------------// Coin Particle Burst //-----------------------------------------------*/
+// Added to the bursts already going, or cut short when the pool is full
+static void spawnCoinBurst(GameState & state, const Vector3f & origin)
+{
+	ParticlePool & particles = state.particles;
+	int first = particles.size();
+	int added = particles.emit(COIN_BURST_PARTICLES);
+	for (int p = first; p < first + added; ++p)
+	{
+		particles.positionX[p] = origin.x;
+		particles.positionY[p] = origin.y;
+		particles.positionZ[p] = origin.z;
+		particles.velocityX[p] = (gameRandom(state) % 100 - 50) / 50.0f; // Random X velocity
+		particles.velocityY[p] = (gameRandom(state) % 100) / 50.0f;		 // Random Y velocity
+		particles.velocityZ[p] = (gameRandom(state) % 100 - 50) / 50.0f; // Random Z velocity
+		particles.life[p] = 1.0f;										 // Each particle lives for 1 second
+	}
+}
+
+/*-----------------------------------------------------// Update the fired balls //----------------------------------------------*/
+static void updateBallPosition(GameState & state, float dt)
+{
+	PROFILE_ZONE("updateBallPosition");
+
+	ProjectilePool & balls = state.projectiles;
+	if (balls.size() == 0)
+		return;
+
+	// Move every ball at once
+	balls.integrate(dt, g, gravityDelay);
+
+	// Then the ground and the maze, ball by ball
+	for (int slot = 0; slot < balls.getSlotLimit(); slot++)
+	{
+		if (balls.active[slot] == 0.0f)
+			continue;
+
+		// A ball that hits the ground is removed, after its last tile check
+		bool landed = balls.positionY[slot] <= 0.9f;
+		if (landed)
+			balls.positionY[slot] = 0.0f;
+
+		// Every maze tile the ball passed over this step - at speed it can cross more than one
+		GridTraversal path(balls.previousX[slot], balls.previousZ[slot], balls.positionX[slot], balls.positionZ[slot]);
+		int ballTileX, ballTileZ;
+		while (path.next(ballTileX, ballTileZ))
+		{
+			// Check if ball is within the maze bounds
+			if (ballTileZ < 0 || ballTileX >= MAZE_HEIGHT || ballTileX < 0 || ballTileZ >= MAZE_WIDTH)
+				continue;
+
+			// If the ball hits a coin tile
+			if (state.MAZE[ballTileX][ballTileZ] == 2)
+			{
+				setMazeTile(state, ballTileX, ballTileZ, 1); // Remove Coin
+
+				// Spawn visual particles
+				spawnCoinBurst(state, Vector3f(balls.positionX[slot], balls.positionY[slot], balls.positionZ[slot]));
+
+				collectCoin(state);
+			}
+		}
+
+		if (landed)
+			balls.despawn(slot);
+	}
+}
+
+/*---------------------------------------------------// Updates active particles //------------------------------------*/
+static void updateParticles(GameState & state, float dt)
+{
+	PROFILE_ZONE("updateParticles");
+
+	// Moves and ages every burst at once, dropping particles whose life ran out
+	state.particles.update(dt);
+}
+
+/*--------------------------------------------------------// Steering Function //-------------------------------------------------*/
+static void updateSteeringAngle(GameState & state, float dt)
+{
+	const float maxSteeringAngle = 15.0f; // Maximum angle the wheels can steer (in degrees)
+	const float returnSpeed = 60.0f;	  // Speed at which the steering returns to center (degrees/sec)
+
+	// Turn right (positive turn direction)
+	if (state.turnDirection > 0.0f)
+	{
+		state.steeringAngle += steeringSpeed * dt; // Increase angle over time
+		if (state.steeringAngle > maxSteeringAngle)
+			state.steeringAngle = maxSteeringAngle; // Clamp to maximum right
+	}
+	// Turn left (negative turn direction)
+	else if (state.turnDirection < 0.0f)
+	{
+		state.steeringAngle -= steeringSpeed * dt; // Decrease angle over time
+		if (state.steeringAngle < -maxSteeringAngle)
+			state.steeringAngle = -maxSteeringAngle; // Clamp to maximum left
+	}
+	// Return to center if no input
+	else
+	{
+		if (state.steeringAngle > 0.0f)
+		{
+			state.steeringAngle -= returnSpeed * dt;
+			if (state.steeringAngle < 0.0f)
+				state.steeringAngle = 0.0f;
+		}
+		else if (state.steeringAngle < 0.0f)
+		{
+			state.steeringAngle += returnSpeed * dt;
+			if (state.steeringAngle > 0.0f)
+				state.steeringAngle = 0.0f;
+		}
+	}
+
+	// Clamp to ensure steering angle is within bounds
+	if (state.steeringAngle > maxSteeringAngle)
+		state.steeringAngle = maxSteeringAngle;
+	if (state.steeringAngle < -maxSteeringAngle)
+		state.steeringAngle = -maxSteeringAngle;
+}
+
+/*------------------------------------------------------// Rotating Turret Function //----------------------------------------------*/
+static void updateTurretRotation(GameState & state)
+{
+	// Do not rotate the turret while the tank is falling
+	if (state.isfalling)
+		return;
+
+	// Calculate the angular difference between current turret rotation and target
+	float angleDifference = state.targetTurretRotation - state.turretBaseRotation;
+
+	// Normalise the angle difference to stay within [-180, 180]
+	if (angleDifference > 180.0f)
+		angleDifference -= 360.0f;
+	if (angleDifference < -180.0f)
+		angleDifference += 360.0f;
+
+	// Apply smooth rotation if the difference is significant
+	if (fabs(angleDifference) > 0.01f)
+	{
+		// Interpolate the turret rotation by 10% of the angle difference
+		state.turretBaseRotation += angleDifference * 0.1f;
+	}
+}
+
+/*-----------------------------------------------------// Camera Function //-------------------------------------------------------*/
+static void updateCameraPosition(GameState & state, float dt)
+{
+	// Only update the camera if the tank is not falling
+	if (state.isfalling)
+		return;
+
+	// Calculate tanks orientation in world space
+	float targetpan = (state.tankRotation + state.turretBaseRotation) * (M_PI / 180.0f);
+
+	/*---------------------------------------// FIRST PERSON CAMERA MODE //-----------------------------------------------------------*/
+	if (state.isFirstPerson)
+	{
+		float smoothing = 10.0f;
+		state.cameraPan += (targetpan - state.cameraPan) * smoothing * dt;
+
+		// Cockpit camera setting - slight downward angle, close to the tank
+		state.cameraTilt = -1.3f;
+		state.cameraRadius = 0.2f;
+
+		// Focus point is directly above the tank chassis to simulate a cockpit view
+		float verticalOffset = 2.0f;
+		state.cameraFocus = Vector3f(state.tankPosition.x, state.tankPosition.y + verticalOffset, state.tankPosition.z);
+	}
+	/*--------------------------------------------------------// THIRD PERSON CAMERA MODE //-----------------------------------------------*/
+	else
+	{
+		float smoothing = 5.0f;
+		state.cameraPan += (targetpan - state.cameraPan) * smoothing * dt;
+
+		// Camera follows from behind at a higher angle than first person
+		state.cameraTilt = -1.0f;
+		state.cameraRadius = cameraDistance;
+		state.cameraFocus = state.tankPosition;
+	}
+}
+
+/*-------------------------------------------------------// Coin Pickup //---------------------------------------------------------*/
+static void updateCoinPickup(GameState & state)
+{
+	// Every tile the tank moved over this step
+	GridTraversal path(state.stepStart.x, state.stepStart.z, state.tankPosition.x, state.tankPosition.z);
+	int tankTileX, tankTileZ;
+	while (path.next(tankTileX, tankTileZ))
+	{
+		if (tankTileZ < 0 || tankTileX >= MAZE_HEIGHT || tankTileX < 0 || tankTileZ >= MAZE_WIDTH)
+			continue;
+
+		if (state.MAZE[tankTileX][tankTileZ] == 2) // 2 indicates a coin tile
+		{
+			setMazeTile(state, tankTileX, tankTileZ, 1); // Remove coin
+			collectCoin(state);
+		}
+	}
+}
+
+/*-------------------------------------------------------// Falling Donuts //------------------------------------------------------*/
+static void updateDonuts(GameState & state, float dt)
+{
+	// Donut tiles the tank drove over on the ground this step, not just the one it stopped on
+	bool driven[MAZE_HEIGHT][MAZE_WIDTH] = {};
+	if (state.isOnGround)
+	{
+		GridTraversal path(state.groundStart.x, state.groundStart.z, state.tankPosition.x, state.tankPosition.z);
+		int tankRow, tankCol;
+		while (path.next(tankRow, tankCol))
+		{
+			if (tankRow >= 0 && tankCol >= 0 && tankRow < MAZE_HEIGHT && tankCol < MAZE_WIDTH)
+				driven[tankRow][tankCol] = true;
+		}
+	}
+
+	for (int i = 0; i < MAZE_HEIGHT; i++)
+	{
+		for (int j = 0; j < MAZE_WIDTH; j++)
+		{
+			if (state.MAZE[i][j] != 3)
+				continue;
+
+			std::pair<int, int> key = std::make_pair(i, j);
+			float & fallTime = state.donutFallTimers[key];
+
+			// Once the tank has been on this tile, it shakes and falls whether or not the tank stays
+			if (driven[i][j] || fallTime > 0.0f)
+				fallTime += dt;
+
+			// Delete the tile when the time is up - summed steps come out a little short of it, so allow a millisecond
+			if (fallTime >= DONUT_FALL_SECONDS - 0.001f)
+			{
+				setMazeTile(state, i, j, 0);
+				state.donutFallTimers.erase(key);
+			}
+		}
+	}
+}
+
+/*-------------------------------------------------------// Game Clock Function //-------------------------------------------------*/
+static void updateGameClock(GameState & state, float dt)
+{
+	// Only update time and game state if not in menu, paused, gamer over, or game won
+	if (state.mainMenu == 0 && !state.isGameOver && !state.isPaused && !state.gameWon && !state.levelComplete)
+	{
+		state.remainingTime -= dt; // Decrease remaining time by simulated seconds
+
+		// If time runs out, trigger game over
+		if (state.remainingTime < 0)
+		{
+			state.remainingTime = 0;
+			state.isGameOver = true;
+			playSound(state, SOUND_GAME_OVER);
+		}
+
+		if (!state.warningPlayed && state.remainingTime <= 100.0f)
+		{
+			if (state.verbose)
+				std::cout << "Play warning sound";
+			playSound(state, SOUND_WARNING);
+			state.warningPlayed = true;
+			state.LowTimeWarning = true;
+		}
+		else if (state.remainingTime <= 6.0f)
+		{
+			state.LowTimeWarning = false;
+		}
+	}
+
+	if (state.LowTimeWarning)
+	{
+		if (state.flashIncreasing)
+			state.flashAlpha += 5.0f * dt;
+		else
+			state.flashAlpha -= 5.0f * dt;
+
+		if (state.flashAlpha <= 0.2f)
+		{
+			state.flashAlpha = 0.2f;
+			state.flashIncreasing = true;
+		}
+		else if (state.flashAlpha >= 1.0f)
+		{
+			state.flashAlpha = 1.0f;
+			state.flashIncreasing = false;
+		}
+	}
+	else
+	{
+		state.flashAlpha = 1.0f;
+		state.flashIncreasing = false;
+	}
+
+	// Update the coin animmation:
+	// Rotate the coin for visual spinning effect
+	state.coinRotationAngle += 200.0f * dt;
+
+	// Keep angle within 0-360 degrees
+	if (state.coinRotationAngle >= 360.0f)
+	{
+		state.coinRotationAngle -= 360.0f;
+	}
+
+	// Bounce animation offset for vertical movement of coins
+	state.coinBounce += 10.0f * dt;
+}
+
+/*-----------------------------------------------------------// Step //------------------------------------------------------------*/
+void step(GameState & state, const Input & input, float dt)
+{
+	PROFILE_ZONE("step");
+
+	state.events.clear();
+
+	// Presses and mouse events in the order they happened
+	for (size_t e = 0; e < input.events.size(); e++)
+	{
+		applyInputEvent(state, input.events[e]);
+		if (state.events.quit)
+			return;
+	}
+
+	// Tile checks this step sweep the tank's path from here
+	state.stepStart = state.tankPosition;
+	state.groundStart = state.tankPosition;
+
+	// Handle keys and tank physics
+	handleKeys(state, input.keys, dt);
+
+	// Projectile, particles and tank controls
+	updateBallPosition(state, dt);
+	updateParticles(state, dt);
+	updateSteeringAngle(state, dt);
+	updateTurretRotation(state);
+	updateCameraPosition(state, dt);
+
+	// Tank collecting coins and standing on donuts
+	updateCoinPickup(state);
+	updateDonuts(state, dt);
+
+	// Level timer and animations
+	updateGameClock(state, dt);
+
+	state.tick++;
+}
+
+/*-----------------------------------------------------------// Hashing //---------------------------------------------------------*/
+// FNV-1a
+static void hashBytes(uint64_t & hash, const void * data, size_t size)
+{
+	const unsigned char * bytes = (const unsigned char *)data;
+	for (size_t b = 0; b < size; b++)
+		hash = (hash ^ bytes[b]) * 1099511628211ULL;
+}
+
+uint64_t hashGameState(const GameState & state)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	hashBytes(hash, &state.tankPosition.x, sizeof(float));
+	hashBytes(hash, &state.tankPosition.y, sizeof(float));
+	hashBytes(hash, &state.tankPosition.z, sizeof(float));
+	hashBytes(hash, &state.tankRotation, sizeof(state.tankRotation));
+	hashBytes(hash, &state.coinsCollected, sizeof(state.coinsCollected));
+	hashBytes(hash, &state.currentLevel, sizeof(state.currentLevel));
+	hashBytes(hash, &state.remainingTime, sizeof(state.remainingTime));
+	for (int slot = 0; slot < state.projectiles.getSlotLimit(); slot++)
+	{
+		if (state.projectiles.active[slot] == 0.0f)
+			continue;
+		hashBytes(hash, &state.projectiles.positionX[slot], sizeof(float));
+		hashBytes(hash, &state.projectiles.positionY[slot], sizeof(float));
+		hashBytes(hash, &state.projectiles.positionZ[slot], sizeof(float));
+	}
+	hashBytes(hash, state.MAZE, sizeof(state.MAZE));
+	return hash;
+}
@@ -0,0 +1,224 @@
+#ifndef GAMESTATE_H_
+#define GAMESTATE_H_
+
+#include <Vector.h>
+#include <ProjectilePool.h>
+#include <ParticlePool.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * The tank game simulation without any rendering, windowing or sound.
+ * Everything that changes while playing lives in one GameState and only
+ * step() advances it, so any number of games can run side by side, at
+ * thousands of steps per second, with nothing but this library linked.
+ */
+
+// Maze System
+const int MAZE_WIDTH = 15;
+const int MAZE_HEIGHT = 15;
+const int finalLevel = 3;
+
+//! Seconds from the tank first driving onto a donut tile to the tile collapsing
+const float DONUT_FALL_SECONDS = 100.0f / 60.0f;
+
+//! Sound effects a step can start - the caller decides how (or whether) to play them
+enum GameSound
+{
+	SOUND_PAUSE,
+	SOUND_JUMP,
+	SOUND_GAME_OVER,
+	SOUND_WARNING,
+	SOUND_COIN,
+	SOUND_STAGE_CLEAR,
+	SOUND_WORLD_CLEAR,
+	SOUND_FALL,
+	SOUND_FIREBALL,
+	SOUND_COUNT
+};
+
+//! File name of a sound effect, relative to the assignment directory
+const char * gameSoundFile(GameSound sound);
+
+//! A maze tile that changed value during a step
+struct TileChange
+{
+	int i;
+	int j;
+	int from;
+	int to;
+};
+
+//! Side effects of the last step for the caller to present
+struct GameEvents
+{
+	std::vector<GameSound> sounds;	//!< Sounds started, in order
+	std::vector<TileChange> tiles;	//!< Tiles changed by pickups and falling donuts
+	bool levelLoaded = false;		//!< The whole maze was replaced
+	bool teleported = false;		//!< The tank was moved without travelling (reset, level switch)
+	bool ballFired = false;			//!< A new ball left the barrel
+	bool quit = false;				//!< The player chose to quit
+
+	//! Forget everything, done at the start of every step
+	void clear();
+};
+
+//! One input event, applied in order at the start of the next step
+struct InputEvent
+{
+	enum Type
+	{
+		KEY_PRESS,	//!< key went down - menus, level switching and camera mode
+		FIRE,		//!< Left mouse button went down
+		AIM_BEGIN,	//!< Right mouse button went down
+		AIM_END,	//!< Right mouse button went up
+		AIM_MOVE	//!< Mouse moved to (x, y) relative to the screen centre, y up
+	};
+
+	Type type;
+	unsigned char key;
+	float x, y;
+};
+
+//! Everything the player does between two steps
+struct Input
+{
+	//! Keys held down during the step
+	bool keys[256];
+
+	//! Presses and mouse events since the previous step
+	std::vector<InputEvent> events;
+
+	//! Constructor - no keys held
+	Input();
+
+	//! Queue an event for the next step
+	void push(InputEvent::Type type, unsigned char key = 0, float x = 0.0f, float y = 0.0f);
+};
+
+//! Particles in the burst a ball sends up when it hits a coin
+const int COIN_BURST_PARTICLES = 100;
+
+//! Complete state of one game
+struct GameState
+{
+	// Level layouts from the maze file, copied into MAZE when a level starts
+	int levels[finalLevel][MAZE_HEIGHT][MAZE_WIDTH] = {};
+	bool levelAvailable[finalLevel] = {false, false, false};
+
+	// Environment / Game State
+	float remainingTime = 200.0f;
+	float flashAlpha = 1.0f;
+
+	bool flashIncreasing = false;
+	bool warningPlayed = false;
+	bool isPaused = false;
+	bool showMenu = false;
+	bool mainMenu = true;
+	bool gameWon = false;
+	bool isGameOver = false;
+	bool LowTimeWarning = false;
+	bool levelComplete = false;
+
+	int currentLevel = 1;
+	int selectedLevel = 1;
+	bool levelCompleted[finalLevel] = {false, false, false};
+
+	// Maze System
+	int MAZE[MAZE_HEIGHT][MAZE_WIDTH] = {};
+
+	// Coin System
+	int coinsCollected = 0;
+	int totalCoins = 0;
+
+	float coinRotationAngle = 0.0f;
+	float coinBounce = 0.0f;
+
+	// Tank State
+	Vector3f tankPosition = Vector3f(MAZE_WIDTH - 1, 0.0f, MAZE_HEIGHT - 1);
+	Vector3f tankVelocity;
+
+	float tankRotation = 0.0f;
+
+	float moveDirection = 0.0f;
+	float turnDirection = 0.0f;
+
+	float wheelRotation = 0.0f;
+	float steeringAngle = 0.0f;
+
+	float verticalVelocity = 0.0f;
+	float fallRotation = 0.0f;
+	bool isfalling = false;
+	bool fallSoundPlayed = false;
+
+	// Jumping
+	bool isJumping = false;
+	bool isOnGround = true;
+	float jumpVelocity = 0.0f;
+
+	// Swept tile checks - the path the tank moved along this step, so no tile is skipped however long the step
+	Vector3f stepStart;		//!< Tank position at the start of the step, coins are picked up from here on
+	Vector3f groundStart;	//!< Where the tank was last on the ground this step, it can fall from here on
+
+	// Camera - applied to the view by the caller
+	float cameraPan = 0.0f;
+	float cameraTilt = 0.0f;
+	float cameraRadius = 1.0f;
+	Vector3f cameraFocus;
+
+	bool isFirstPerson = false;
+	bool aiming = false;
+
+	// Turret
+	float turretBaseRotation = 0.0f;
+	float targetTurretRotation = 0.0f;
+
+	// Balls in flight
+	ProjectilePool projectiles;
+
+	//! Balls allowed in flight at once - 1 is the original one-shot rule, up to ProjectilePool::CAPACITY for rapid fire
+	int shotLimit = 1;
+
+	// Falling donut tiles - seconds since the tank first stood on them
+	std::map<std::pair<int, int>, float> donutFallTimers;
+
+	// Coin pickup particles, from every burst still going
+	ParticlePool particles;
+
+	//! Random number state - particle bursts repeat for the same seed
+	unsigned int randomSeed = 1;
+
+	//! Steps run so far
+	unsigned int tick = 0;
+
+	//! Print level and pickup messages to the console
+	bool verbose = true;
+
+	//! What the last step did that the caller may want to show or play
+	GameEvents events;
+};
+
+//! Read every level of a maze file into the state, false if none were found
+bool loadLevels(GameState & state, const std::string & filename);
+
+//! Start a level from the loaded layouts (keeps the layout and reports an error if it is missing)
+void loadMaze(GameState & state, int level);
+
+//! Move forwards or backwards through the levels, winning after the final one
+void switchLevel(GameState & state, int direction);
+
+//! Reload the level, back to the main menu with the tank at the centre
+void resetGame(GameState & state);
+
+//! Start playing a level straight away, as if it had been picked from the main menu
+void startLevel(GameState & state, int level);
+
+//! Apply the input and advance the game by dt seconds
+void step(GameState & state, const Input & input, float dt);
+
+//! FNV-1a hash of the state a replay has to reproduce exactly
+uint64_t hashGameState(const GameState & state);
+
+#endif
@@ -0,0 +1,96 @@
+#include "GridTraversal.h"
+#include <math.h>
+#include <stdlib.h>
+
+//! Tiles are 2 units wide with edges on the odd coordinates, so shift by 1 and halve to get tile units
+static float toTileUnits(float position)
+{
+	return (position + 1.0f) * 0.5f;
+}
+
+//! Constructor - start and end tiles, and the first crossing along each axis
+GridTraversal::GridTraversal(float startX, float startZ, float endX, float endZ)
+{
+	float u0 = toTileUnits(startX), v0 = toTileUnits(startZ);
+	float u1 = toTileUnits(endX), v1 = toTileUnits(endZ);
+	float du = u1 - u0, dv = v1 - v0;
+
+	row = (int)floorf(u0);
+	column = (int)floorf(v0);
+	rowsLeft = abs((int)floorf(u1) - row);
+	columnsLeft = abs((int)floorf(v1) - column);
+
+	rowStep = du < 0.0f ? -1 : 1;
+	columnStep = dv < 0.0f ? -1 : 1;
+
+	// A segment that never crosses along an axis never needs its distances, which would divide by zero
+	rowCrossing = rowSpacing = INFINITY;
+	if (rowsLeft > 0)
+	{
+		rowCrossing = ((du < 0.0f ? row : row + 1) - u0) / du;
+		rowSpacing = 1.0f / fabsf(du);
+	}
+	columnCrossing = columnSpacing = INFINITY;
+	if (columnsLeft > 0)
+	{
+		columnCrossing = ((dv < 0.0f ? column : column + 1) - v0) / dv;
+		columnSpacing = 1.0f / fabsf(dv);
+	}
+
+	entry = 0.0f;
+	started = false;
+}
+
+//! Step across whichever tile edge the segment reaches first
+bool GridTraversal::next(int & nextRow, int & nextColumn)
+{
+	if (!started)
+	{
+		started = true;
+	}
+	else if (rowsLeft > 0 && (columnsLeft == 0 || rowCrossing < columnCrossing))
+	{
+		entry = rowCrossing;
+		row += rowStep;
+		rowCrossing += rowSpacing;
+		rowsLeft--;
+	}
+	else if (columnsLeft > 0)
+	{
+		entry = columnCrossing;
+		column += columnStep;
+		columnCrossing += columnSpacing;
+		columnsLeft--;
+	}
+	else
+	{
+		return false;
+	}
+
+	nextRow = row;
+	nextColumn = column;
+	return true;
+}
+
+//! Fraction the current tile starts at
+float GridTraversal::getEntry() const
+{
+	return entry;
+}
+
+//! Fraction the current tile ends at, the end of the segment for the last tile
+float GridTraversal::getExit() const
+{
+	float exit = 1.0f;
+	if (rowsLeft > 0 && rowCrossing < exit)
+		exit = rowCrossing;
+	if (columnsLeft > 0 && columnCrossing < exit)
+		exit = columnCrossing;
+	return exit;
+}
+
+//! Tile edges at odd coordinates - the tile round(position / 2) picks, with halves always rounded up
+int GridTraversal::tileOf(float position)
+{
+	return (int)floorf(toTileUnits(position));
+}
@@ -0,0 +1,48 @@
+#ifndef GRIDTRAVERSAL_H_
+#define GRIDTRAVERSAL_H_
+
+/**
+ * Walks every maze tile a straight segment passes through, in the order it
+ * passes through them (Amanatides and Woo's grid traversal). Tile (i, j)
+ * is centred at world (2i, 2j) and is 2 units wide, so its row comes from
+ * x and its column from z, the same tiles round(x / 2) picks. Collision
+ * checks that walk the path moved in a step, rather than looking only at
+ * where it ended, cannot jump over a tile however long the step is.
+ *
+ * The walk ends on the tile holding the end point; the number of row and
+ * column crossings is worked out up front, so rounding in the crossing
+ * distances can change the order of a corner but never the last tile.
+ */
+class GridTraversal
+{
+
+public:
+
+	//! Walk from (startX, startZ) to (endX, endZ), in world units on the ground plane
+	GridTraversal(float startX, float startZ, float endX, float endZ);
+
+	//! Next tile along the segment, starting with the one holding the start point; false after the end tile
+	bool next(int & row, int & column);
+
+	//! Fraction of the segment, 0-1, at which the tile last returned by next() is entered
+	float getEntry() const;
+
+	//! Fraction of the segment, 0-1, at which the tile last returned by next() is left
+	float getExit() const;
+
+	//! Tile of a world coordinate along either axis
+	static int tileOf(float position);
+
+private:
+
+	int row, column;
+	int rowStep, columnStep;		//!< Direction of travel, -1 or 1
+	int rowsLeft, columnsLeft;		//!< Crossings still to make
+	float rowCrossing, columnCrossing;	//!< Fraction of the segment at the next crossing along each axis
+	float rowSpacing, columnSpacing;	//!< Fraction of the segment between crossings along each axis
+	float entry;
+	bool started;
+
+};
+
+#endif
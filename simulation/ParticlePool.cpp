@@ -0,0 +1,131 @@
+#include "ParticlePool.h"
+#include <Matrix.h>
+#include <Profiler.h>
+
+// Without SSE the particles are updated one at a time
+#ifdef GAME_SSE
+#include <immintrin.h>
+#endif
+
+const int ParticlePool::CAPACITY;
+
+//! Constructor
+ParticlePool::ParticlePool()
+{
+	// Whole groups of four are loaded, so the slack after the last live particle must hold numbers too
+	for (int p = 0; p < CAPACITY; p++)
+	{
+		positionX[p] = positionY[p] = positionZ[p] = 0.0f;
+		velocityX[p] = velocityY[p] = velocityZ[p] = 0.0f;
+		life[p] = 0.0f;
+	}
+	clear();
+}
+
+//! Nothing live; the arrays keep their memory
+void ParticlePool::clear()
+{
+	count = 0;
+	dropped = 0;
+	updateNanoseconds = 0;
+}
+
+//! Grow the live range, as far as the capacity allows
+int ParticlePool::emit(int wanted)
+{
+	int added = wanted < CAPACITY - count ? wanted : CAPACITY - count;
+	if (added < 0)
+		added = 0;
+
+	dropped += wanted - added;
+	count += added;
+	return added;
+}
+
+//! One pass over the live range, plus a compaction pass on the steps where particles die
+void ParticlePool::update(float dt)
+{
+	if (count == 0)
+	{
+		updateNanoseconds = 0;
+		return;
+	}
+
+	uint64_t start = Profiler::now();
+	int anyDead = 0;
+
+#ifdef GAME_SSE
+	// Four particles per iteration; lanes past the last live particle are moved too but never counted
+	__m128 step = _mm_set1_ps(dt);
+	__m128 zero = _mm_setzero_ps();
+	for (int p = 0; p < count; p += 4)
+	{
+		__m128 remaining = _mm_sub_ps(_mm_load_ps(life + p), step);
+		_mm_store_ps(life + p, remaining);
+
+		_mm_store_ps(positionX + p, _mm_add_ps(_mm_load_ps(positionX + p), _mm_mul_ps(_mm_load_ps(velocityX + p), step)));
+		_mm_store_ps(positionY + p, _mm_add_ps(_mm_load_ps(positionY + p), _mm_mul_ps(_mm_load_ps(velocityY + p), step)));
+		_mm_store_ps(positionZ + p, _mm_add_ps(_mm_load_ps(positionZ + p), _mm_mul_ps(_mm_load_ps(velocityZ + p), step)));
+
+		int dead = _mm_movemask_ps(_mm_cmple_ps(remaining, zero));
+		if (count - p < 4)
+			dead &= (1 << (count - p)) - 1;
+		anyDead |= dead;
+	}
+#else
+	for (int p = 0; p < count; p++)
+	{
+		life[p] -= dt;
+		positionX[p] += velocityX[p] * dt;
+		positionY[p] += velocityY[p] * dt;
+		positionZ[p] += velocityZ[p] * dt;
+		anyDead |= life[p] <= 0.0f;
+	}
+#endif
+
+	if (anyDead)
+		removeDead();
+
+	updateNanoseconds = Profiler::now() - start;
+}
+
+//! Swap-remove: the last live particle takes the dead one's place, and is checked in turn
+void ParticlePool::removeDead()
+{
+	int p = 0;
+	while (p < count)
+	{
+		if (life[p] > 0.0f)
+		{
+			p++;
+			continue;
+		}
+
+		count--;
+		positionX[p] = positionX[count];
+		positionY[p] = positionY[count];
+		positionZ[p] = positionZ[count];
+		velocityX[p] = velocityX[count];
+		velocityY[p] = velocityY[count];
+		velocityZ[p] = velocityZ[count];
+		life[p] = life[count];
+	}
+}
+
+//! Live particles
+int ParticlePool::size() const
+{
+	return count;
+}
+
+//! Particles that did not fit
+unsigned int ParticlePool::getDroppedCount() const
+{
+	return dropped;
+}
+
+//! Last update() time
+uint64_t ParticlePool::getUpdateNanoseconds() const
+{
+	return updateNanoseconds;
+}
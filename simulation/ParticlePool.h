@@ -0,0 +1,65 @@
+#ifndef PARTICLEPOOL_H_
+#define PARTICLEPOOL_H_
+
+#include <stdint.h>
+
+/**
+ * Every live particle of every burst, one array per component, allocated
+ * once. Live particles are always packed at the front: emit() appends a
+ * burst after them and a particle that dies is replaced by the last one,
+ * so any number of bursts can overlap without clearing one another, and
+ * update() only ever walks the live range.
+ *
+ * update() moves and ages four particles at a time with SSE and notes
+ * whether any died; the compaction pass only runs on steps where one did.
+ */
+class ParticlePool
+{
+
+public:
+
+	//! Particles alive at once - enough for every coin of a level to burst together
+	static const int CAPACITY = 1024;
+
+	//! Constructor - empty
+	ParticlePool();
+
+	//! Remove every particle
+	void clear();
+
+	//! Append up to count particles at index size() before the call, returning how many fit; the caller fills them in
+	int emit(int count);
+
+	//! Move every particle along its velocity, age it by dt and remove the ones whose life ran out
+	void update(float dt);
+
+	//! Live particles, at indices 0 to size() - 1
+	int size() const;
+
+	//! Particles asked for by emit() since the last clear() that did not fit
+	unsigned int getDroppedCount() const;
+
+	//! Wall clock time the last update() took, in nanoseconds
+	uint64_t getUpdateNanoseconds() const;
+
+	//! Per-particle state, 16-byte aligned so update() works on four at a time
+	alignas(16) float positionX[CAPACITY];
+	alignas(16) float positionY[CAPACITY];
+	alignas(16) float positionZ[CAPACITY];
+	alignas(16) float velocityX[CAPACITY];
+	alignas(16) float velocityY[CAPACITY];
+	alignas(16) float velocityZ[CAPACITY];
+	alignas(16) float life[CAPACITY];	//!< Seconds left, the particle fades as it runs out
+
+private:
+
+	//! Replace every dead particle with the last live one
+	void removeDead();
+
+	int count;
+	unsigned int dropped;
+	uint64_t updateNanoseconds;
+
+};
+
+#endif
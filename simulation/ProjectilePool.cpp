@@ -0,0 +1,112 @@
+#include "ProjectilePool.h"
+#include <math.h>
+
+//! The fall speed is one 60 Hz step of the eased gravity, whatever step integrate() is given
+static const float FALL_STEP = 1.0f / 60.0f;
+
+const int ProjectilePool::CAPACITY;
+
+//! Constructor
+ProjectilePool::ProjectilePool()
+{
+	clear();
+}
+
+//! Every slot free, slot 0 handed out first
+void ProjectilePool::clear()
+{
+	for (int slot = 0; slot < CAPACITY; slot++)
+	{
+		positionX[slot] = positionY[slot] = positionZ[slot] = 0.0f;
+		previousX[slot] = previousZ[slot] = 0.0f;
+		velocityX[slot] = velocityY[slot] = velocityZ[slot] = 0.0f;
+		lifeTime[slot] = 0.0f;
+		rotation[slot] = 0.0f;
+		active[slot] = 0.0f;
+		serial[slot] = 0;
+		freeSlots[slot] = CAPACITY - 1 - slot;
+	}
+	freeCount = CAPACITY;
+	slotLimit = 0;
+	launched = 0;
+}
+
+//! Pop a free slot and start it at rest vertically
+int ProjectilePool::spawn(float x, float y, float z, float vx, float vz)
+{
+	if (freeCount == 0)
+		return -1;
+
+	int slot = freeSlots[--freeCount];
+	positionX[slot] = x;
+	positionY[slot] = y;
+	positionZ[slot] = z;
+	previousX[slot] = x;
+	previousZ[slot] = z;
+	velocityX[slot] = vx;
+	velocityY[slot] = 0.0f;
+	velocityZ[slot] = vz;
+	lifeTime[slot] = 0.0f;
+	rotation[slot] = 0.0f;
+	active[slot] = 1.0f;
+	serial[slot] = ++launched;
+
+	if (slot >= slotLimit)
+		slotLimit = slot + 1;
+	return slot;
+}
+
+//! Push the slot back on the free list
+void ProjectilePool::despawn(int slot)
+{
+	if (active[slot] == 0.0f)
+		return;
+
+	active[slot] = 0.0f;
+	freeSlots[freeCount++] = slot;
+}
+
+//! Straight-line motion for every slot at once, then the gravity, which needs expf and so stays scalar
+void ProjectilePool::integrate(float dt, float gravity, float gravityDelay)
+{
+	// No branches or calls, and a fixed trip count, so this loop vectorises even at -O2; free slots get a zero step
+	for (int slot = 0; slot < CAPACITY; slot++)
+	{
+		float step = dt * active[slot];
+		lifeTime[slot] += step;
+		rotation[slot] += 270.0f * step; // 270 degrees per second
+		previousX[slot] = positionX[slot];
+		previousZ[slot] = positionZ[slot];
+		positionX[slot] += velocityX[slot] * step;
+		positionZ[slot] += velocityZ[slot] * step;
+	}
+
+	// Eased gravity after a short delay. The fall speed is one 60 Hz step of it, not a sum over steps - the speed
+	// the projectile always had, when it shared the tank's vertical velocity and the tank reset it every step.
+	// A fixed step rather than dt, so a ball flies the same distance at any step rate
+	for (int slot = 0; slot < slotLimit; slot++)
+	{
+		if (active[slot] == 0.0f)
+			continue;
+
+		// Keep the roll within 0-360 degrees
+		if (rotation[slot] > 360.0f)
+			rotation[slot] -= 360.0f;
+
+		float t = lifeTime[slot] - gravityDelay;
+		velocityY[slot] = t >= 0.0f ? gravity * (1.0f - expf(-3.0f * t)) * 30.0f * FALL_STEP : 0.0f;
+		positionY[slot] += velocityY[slot] * dt;
+	}
+}
+
+//! Projectiles in flight
+int ProjectilePool::size() const
+{
+	return CAPACITY - freeCount;
+}
+
+//! Loop bound
+int ProjectilePool::getSlotLimit() const
+{
+	return slotLimit;
+}
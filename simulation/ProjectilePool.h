@@ -0,0 +1,69 @@
+#ifndef PROJECTILEPOOL_H_
+#define PROJECTILEPOOL_H_
+
+/**
+ * Every projectile in flight, stored as one array per component so the
+ * motion of all of them is integrated by one loop the compiler vectorises.
+ * Slots are handed out and returned through a free list, so spawning and
+ * despawning never search or move anything. Free slots keep their last
+ * values; active[] is 1 for a projectile in flight and 0 otherwise, and
+ * scales the time step so free slots stand still.
+ *
+ * Only slots below getSlotLimit() have ever been used, so loops that look
+ * at projectiles one by one stop there rather than at CAPACITY.
+ */
+class ProjectilePool
+{
+
+public:
+
+	//! Projectiles that can be in flight at once
+	static const int CAPACITY = 64;
+
+	//! Constructor - empty
+	ProjectilePool();
+
+	//! Free every slot
+	void clear();
+
+	//! Launch a projectile with a horizontal velocity, returning its slot or -1 when the pool is full
+	int spawn(float x, float y, float z, float velocityX, float velocityZ);
+
+	//! Return a slot to the free list
+	void despawn(int slot);
+
+	//! Advance every projectile by dt: lifetime, roll and motion, with gravity easing in after gravityDelay
+	void integrate(float dt, float gravity, float gravityDelay);
+
+	//! Projectiles in flight
+	int size() const;
+
+	//! One past the highest slot ever used
+	int getSlotLimit() const;
+
+	//! Per-slot state
+	float positionX[CAPACITY];
+	float positionY[CAPACITY];
+	float positionZ[CAPACITY];
+	float previousX[CAPACITY];		//!< Ground position before the last integrate(), where the path swept in that step starts
+	float previousZ[CAPACITY];
+	float velocityX[CAPACITY];
+	float velocityY[CAPACITY];
+	float velocityZ[CAPACITY];
+	float lifeTime[CAPACITY];		//!< Seconds since launch
+	float rotation[CAPACITY];		//!< Roll in degrees, 0-360
+	float active[CAPACITY];			//!< 1 in flight, 0 free
+	unsigned int serial[CAPACITY];	//!< Launch number of the projectile in the slot, so a reused slot can be told apart
+
+private:
+
+	//! Free slots, the next one to use on top
+	int freeSlots[CAPACITY];
+	int freeCount;
+
+	int slotLimit;
+	unsigned int launched;
+
+};
+
+#endif
@@ -0,0 +1,29 @@
+TEMPLATE = lib
+
+#Library Name - the game simulation without OpenGL, GLUT or sound
+TARGET = Simulation
+CONFIG = staticlib release
+
+#Destination
+DESTDIR = .
+OBJECTS_DIR = ./build/
+
+HEADERS	+= 	GameState.h		        \
+        ProjectilePool.h                \
+        ParticlePool.h                  \
+        GridTraversal.h                 \
+		../common/Vector.h		        \
+        ../common/Matrix.h              \
+        ../common/Profiler.h            \
+
+#Sources
+SOURCES += 	GameState.cpp		        \
+        ProjectilePool.cpp              \
+        ParticlePool.cpp                \
+        GridTraversal.cpp               \
+        ../common/Profiler.cpp          \
+
+INCLUDEPATH += 	./ 				    \
+		        ../common/ 			\
+
+#Library Libraries - none, users link -lSimulation (and -pthread for the profiler)